@@ -1,5 +1,9 @@
 TEMPLATE=subdirs
 SUBDIRS +=src
+# 命令行查询 everylauncher-query
+SUBDIRS += query
+# qmake CONFIG+=bench 时同时构建 bench/ 下的基准测试
+bench: SUBDIRS += bench
 
 
 # The following define makes your compiler emit warnings if you use
@@ -29,6 +33,9 @@ deplib.path=$${PREFIX}/
 desktop.files=$$PWD/EveryLauncher.desktop
 desktop.path=$${PREFIX}/share/applications/
 
+autostart.files=$$PWD/EveryLauncher-resident.desktop
+autostart.path=/etc/xdg/autostart
+
 desktopicon.files=$$PWD/everylauncher.svg
 desktopicon.path=$$PREFIX/share/icons/hicolor/scalable/apps
 
@@ -41,4 +48,4 @@ filters.path=$$PREFIX/share/everylauncher/
 icon.files=$$PWD/icon
 icon.path=$$PREFIX/share/everylauncher/
 
-INSTALLS += dbus_service dbus_toggle deplib desktop recoll_conf filters icon desktopicon
+INSTALLS += dbus_service dbus_toggle deplib desktop autostart recoll_conf filters icon desktopicon
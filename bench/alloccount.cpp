@@ -0,0 +1,36 @@
+#include "alloccount.h"
+
+#include <atomic>
+#include <cstddef>
+
+static std::atomic<uint64_t> s_allocations{0};
+
+extern "C" {
+// glibc 导出的原始实现
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+
+uint64_t AllocCount::count()
+{
+    return s_allocations.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,26 @@
+#ifndef ALLOCCOUNT_H
+#define ALLOCCOUNT_H
+
+#include <cstdint>
+
+/*
+ * 统计进程里 malloc/calloc/realloc 的调用次数。
+ * 链接了 alloccount.cpp 的程序会替换掉 glibc 的这几个函数，
+ * new 和 Qt 的容器最后都会走到这里。
+ */
+namespace AllocCount {
+uint64_t count();
+
+// 作用域内的分配次数
+class Scope
+{
+public:
+    Scope() : m_start(count()) {}
+    uint64_t allocations() const { return count() - m_start; }
+
+private:
+    uint64_t m_start;
+};
+}
+
+#endif // ALLOCCOUNT_H
@@ -0,0 +1,19 @@
+# 各个基准测试共用的设置，和 src/src.pro 保持一致
+CONFIG += c++11 console
+CONFIG -= app_bundle
+QMAKE_CXXFLAGS += -std=c++11
+
+LIBS += -lrecoll
+LIBS += -L$$PWD/../lib
+QMAKE_RPATHDIR += /usr/lib/recoll
+
+SRCDIR = $$PWD/../src
+INCLUDEPATH += $$SRCDIR \
+                $$PWD \
+                ../../../recoll1-code/src/query\
+                ../../../recoll1-code/src/utils\
+                ../../../recoll1-code/src/rcldb\
+                ../../../recoll1-code/src/internfile\
+                ../../../recoll1-code/src/unac\
+                ../../../recoll1-code/src/common\
+                ../../../recoll1-code/src/qtgui
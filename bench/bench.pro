@@ -0,0 +1,3 @@
+# 基准测试，不随软件包安装。用 qmake CONFIG+=bench 从顶层一起构建
+TEMPLATE = subdirs
+SUBDIRS += modelbench replay
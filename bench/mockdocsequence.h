@@ -0,0 +1,80 @@
+#ifndef MOCKDOCSEQUENCE_H
+#define MOCKDOCSEQUENCE_H
+
+#include <docseq.h>
+#include <rcldoc.h>
+
+#include <string>
+#include <vector>
+
+/*
+ * 内存里的结果序列，文档是按编号确定生成的，不需要 Xapian 索引。
+ * 字段和 DocSequenceDb 返回的一样（meta 里的 url、mtype、filename、abstract 等），
+ * 每隔几个文档有一个 application/x-all 的程序。
+ */
+class MockDocSequence : public DocSequence
+{
+public:
+    explicit MockDocSequence(int count) : DocSequence("mock") {
+        m_docs.reserve(count);
+        for (int i = 0; i < count; i++) {
+            m_docs.push_back(makeDoc(i));
+        }
+    }
+
+    static Rcl::Doc makeDoc(int i) {
+        static const char *const mimes[] = {
+            "application/pdf", "text/plain", "text/x-c", "image/png",
+            "application/vnd.oasis.opendocument.text", "application/x-all",
+        };
+        auto num = std::to_string(i);
+        std::string mime = mimes[i % 6];
+        Rcl::Doc doc;
+        doc.mimetype = mime;
+        doc.pc = 100 - i % 100;
+        doc.fmtime = std::to_string(1500000000 + i);
+        doc.fbytes = std::to_string(1000 + i * 7 % 100000);
+        if (mime == "application/x-all") {
+            doc.url = "file:///usr/share/applications/bench-app" + num + ".desktop";
+            doc.meta["appname"] = "Bench App " + num;
+            doc.meta["appcomment"] = "Synthetic application number " + num;
+            doc.meta["appicon"] = "/usr/share/icons/hicolor/48x48/apps/bench" + num + ".png";
+            doc.meta["appexec"] = "bench-app" + num + " %U";
+            doc.meta["appnodisplay"] = "false";
+        } else {
+            doc.url = "file:///home/bench/dir" + std::to_string(i % 97) + "/file" + num + ".txt";
+        }
+        doc.meta[Rcl::Doc::keyurl] = doc.url;
+        doc.meta[Rcl::Doc::keymt] = mime;
+        doc.meta[Rcl::Doc::keyfn] = doc.url.substr(doc.url.rfind('/') + 1);
+        doc.meta[Rcl::Doc::keytt] = "Title of document " + num;
+        doc.meta[Rcl::Doc::keyabs] =
+                "Abstract for document " + num +
+                " with a few words of context around the matched search terms, "
+                "long enough to look like a real snippet.";
+        doc.meta["relevancyrating"] = std::to_string(doc.pc) + " %";
+        return doc;
+    }
+
+    bool getDoc(int num, Rcl::Doc &doc, std::string *sh = nullptr) override {
+        if (sh) {
+            sh->erase();
+        }
+        if (num < 0 || num >= int(m_docs.size())) {
+            return false;
+        }
+        doc = m_docs[num];
+        return true;
+    }
+
+    int getResCnt() override { return int(m_docs.size()); }
+    std::string getDescription() override { return "mock"; }
+
+protected:
+    Rcl::Db *getDb() override { return nullptr; }
+
+private:
+    std::vector<Rcl::Doc> m_docs;
+};
+
+#endif // MOCKDOCSEQUENCE_H
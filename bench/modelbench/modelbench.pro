@@ -0,0 +1,25 @@
+# 结果列表的模型、分组代理和绘制的基准测试，不需要索引也不需要 X：
+#   ./modelbench -platform offscreen
+TARGET = modelbench
+TEMPLATE = app
+QT += core gui widgets testlib
+
+include(../bench.pri)
+
+SOURCES += \
+    tst_modelbench.cpp \
+    $$SRCDIR/recollmodel.cpp \
+    $$SRCDIR/msortfilterproxymodel.cpp \
+    $$SRCDIR/restabledelegate.cpp \
+    $$SRCDIR/docseqranked.cpp \
+    $$SRCDIR/frecency.cpp \
+    $$SRCDIR/querytrace.cpp \
+    ../alloccount.cpp
+
+HEADERS += \
+    ../mockdocsequence.h \
+    ../alloccount.h \
+    $$SRCDIR/recollmodel.h \
+    $$SRCDIR/msortfilterproxymodel.h \
+    $$SRCDIR/restabledelegate.h \
+    $$SRCDIR/docseqranked.h
@@ -0,0 +1,300 @@
+#include <QImage>
+#include <QMap>
+#include <QPainter>
+#include <QStandardPaths>
+#include <QStyleOptionViewItem>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <memory>
+
+#include <rclconfig.h>
+#include <rclinit.h>
+
+#include "alloccount.h"
+#include "mockdocsequence.h"
+#include "msortfilterproxymodel.h"
+#include "recollmodel.h"
+#include "restabledelegate.h"
+
+RclConfig *theconfig = nullptr;
+
+static QtMessageHandler s_prevHandler = nullptr;
+
+// 绘制时每个找不到的图标都会打印一行，输出到终端的时间会盖过绘制本身
+static void dropDebug(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+    if (type != QtDebugMsg && s_prevHandler) {
+        s_prevHandler(type, context, msg);
+    }
+}
+
+/*
+ * 结果列表热路径的基准测试：RecollModel、MSortFilterProxyModel、ResTableDelegate。
+ * 每一项分别在 10、1000、100000 行上测量，allocations 报告一次操作的 malloc 次数。
+ */
+class ModelBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void readDocSource_data() { addRowCounts(); }
+    void readDocSource();
+    void rowCount_data() { addRowCounts(); }
+    void rowCount();
+    void roleData_data();
+    void roleData();
+    void proxyFilter_data() { addRowCounts(); }
+    void proxyFilter();
+    void mapToSource_data() { addRowCounts(); }
+    void mapToSource();
+    void paint_data() { addRowCounts(); }
+    void paint();
+    void sizeHint_data() { addRowCounts(); }
+    void sizeHint();
+    void allocations_data();
+    void allocations();
+
+private:
+    static void addRowCounts();
+    std::shared_ptr<MockDocSequence> sequence(int rows);
+    // 已经读入 rows 行的模型
+    std::unique_ptr<RecollModel> loadedModel(int rows);
+    QStyleOptionViewItem itemOption() const;
+    void runOp(const QString &op, int rows);
+
+private:
+    QTemporaryDir m_confDir;
+    QStringList m_fields;
+    QMap<int, std::shared_ptr<MockDocSequence>> m_sequences;
+    // 防止结果没有被使用的循环被优化掉
+    qint64 m_sink{0};
+};
+
+void ModelBench::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_confDir.isValid());
+    std::string reason;
+    auto confdir = m_confDir.path().toStdString();
+    theconfig = recollinit(0, nullptr, nullptr, reason, &confdir);
+    QVERIFY2(theconfig && theconfig->ok(), reason.c_str());
+    m_fields << "url" << "title" << "mtype" << "abstract";
+    s_prevHandler = qInstallMessageHandler(dropDebug);
+}
+
+void ModelBench::cleanupTestCase()
+{
+    qInstallMessageHandler(s_prevHandler);
+    QVERIFY(m_sink >= 0);
+}
+
+void ModelBench::addRowCounts()
+{
+    QTest::addColumn<int>("rows");
+    for (int rows : {10, 1000, 100000}) {
+        QTest::newRow(QByteArray::number(rows).constData()) << rows;
+    }
+}
+
+std::shared_ptr<MockDocSequence> ModelBench::sequence(int rows)
+{
+    auto &seq = m_sequences[rows];
+    if (!seq) {
+        seq = std::make_shared<MockDocSequence>(rows);
+    }
+    return seq;
+}
+
+std::unique_ptr<RecollModel> ModelBench::loadedModel(int rows)
+{
+    std::unique_ptr<RecollModel> model(new RecollModel(m_fields));
+    model->setDocSource(sequence(rows));
+    model->readDocSource();
+    return model;
+}
+
+QStyleOptionViewItem ModelBench::itemOption() const
+{
+    QStyleOptionViewItem option;
+    option.rect = QRect(0, 0, 400, 50);
+    option.palette = QGuiApplication::palette();
+    option.state = QStyle::State_Enabled;
+    return option;
+}
+
+void ModelBench::readDocSource()
+{
+    QFETCH(int, rows);
+    auto seq = sequence(rows);
+    QBENCHMARK {
+        RecollModel model(m_fields);
+        model.setDocSource(seq);
+        model.readDocSource();
+        m_sink += model.rowCount(QModelIndex());
+    }
+    QCOMPARE(loadedModel(rows)->rowCount(QModelIndex()), rows);
+}
+
+void ModelBench::rowCount()
+{
+    QFETCH(int, rows);
+    auto model = loadedModel(rows);
+    QBENCHMARK {
+        m_sink += model->rowCount(QModelIndex());
+    }
+}
+
+void ModelBench::roleData_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<int>("role");
+    const QList<QPair<const char *, int>> roles = {
+        {"filename", RecollModel::Role_FILE_NAME},
+        {"location", RecollModel::Role_LOCATION},
+        {"mimetype", RecollModel::Role_MIME_TYPE},
+        {"icon", RecollModel::Role_ICON_PATH},
+        {"abstract", RecollModel::Role_FILE_SIMPLE_CONTENT},
+        {"group", RecollModel::Role_GROUP},
+    };
+    for (int rows : {10, 1000, 100000}) {
+        for (const auto &role : roles) {
+            QTest::newRow(QString("%1/%2").arg(rows).arg(role.first).toUtf8().constData())
+                    << rows << role.second;
+        }
+    }
+}
+
+void ModelBench::roleData()
+{
+    QFETCH(int, rows);
+    QFETCH(int, role);
+    auto model = loadedModel(rows);
+    QBENCHMARK {
+        for (int r = 0; r < rows; r++) {
+            m_sink += model->data(model->index(r), role).toString().size();
+        }
+    }
+}
+
+void ModelBench::proxyFilter()
+{
+    QFETCH(int, rows);
+    auto model = loadedModel(rows);
+    MSortFilterProxyModel proxy(nullptr);
+    proxy.setSourceModel(model.get());
+    QBENCHMARK {
+        // 改每组显示的条数和源模型变化一样，从头重新分组
+        proxy.setMaxItemCount(4);
+        m_sink += proxy.rowCount(QModelIndex());
+    }
+}
+
+void ModelBench::mapToSource()
+{
+    QFETCH(int, rows);
+    auto model = loadedModel(rows);
+    MSortFilterProxyModel proxy(nullptr);
+    proxy.setSourceModel(model.get());
+    auto count = proxy.rowCount(QModelIndex());
+    QVERIFY(count > 0);
+    QBENCHMARK {
+        for (int r = 0; r < count; r++) {
+            m_sink += proxy.mapToSource(proxy.index(r, 0)).row();
+        }
+    }
+}
+
+void ModelBench::paint()
+{
+    QFETCH(int, rows);
+    auto model = loadedModel(rows);
+    ResTableDelegate delegate(nullptr);
+    QImage image(400, 50, QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&image);
+    auto option = itemOption();
+    QBENCHMARK {
+        for (int r = 0; r < rows; r++) {
+            delegate.paint(&painter, option, model->index(r));
+        }
+    }
+}
+
+void ModelBench::sizeHint()
+{
+    QFETCH(int, rows);
+    auto model = loadedModel(rows);
+    ResTableDelegate delegate(nullptr);
+    auto option = itemOption();
+    QBENCHMARK {
+        for (int r = 0; r < rows; r++) {
+            m_sink += delegate.sizeHint(option, model->index(r)).height();
+        }
+    }
+}
+
+void ModelBench::allocations_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<QString>("op");
+    for (int rows : {10, 1000, 100000}) {
+        for (const char *op : {"readDocSource", "data", "proxyFilter", "paint"}) {
+            QTest::newRow(QString("%1/%2").arg(rows).arg(op).toUtf8().constData())
+                    << rows << QString(op);
+        }
+    }
+}
+
+// 只执行一次，分配次数用 Events 报告
+void ModelBench::allocations()
+{
+    QFETCH(int, rows);
+    QFETCH(QString, op);
+    runOp(op, rows);
+}
+
+void ModelBench::runOp(const QString &op, int rows)
+{
+    if (op == "readDocSource") {
+        auto seq = sequence(rows);
+        AllocCount::Scope scope;
+        RecollModel model(m_fields);
+        model.setDocSource(seq);
+        model.readDocSource();
+        QTest::setBenchmarkResult(scope.allocations(), QTest::Events);
+        return;
+    }
+    auto model = loadedModel(rows);
+    if (op == "data") {
+        AllocCount::Scope scope;
+        for (int r = 0; r < rows; r++) {
+            for (int role = RecollModel::Role_FILE_NAME; role <= RecollModel::Role_GROUP;
+                 role++) {
+                m_sink += model->data(model->index(r), role).toString().size();
+            }
+        }
+        QTest::setBenchmarkResult(scope.allocations(), QTest::Events);
+    } else if (op == "proxyFilter") {
+        MSortFilterProxyModel proxy(nullptr);
+        AllocCount::Scope scope;
+        proxy.setSourceModel(model.get());
+        QTest::setBenchmarkResult(scope.allocations(), QTest::Events);
+    } else if (op == "paint") {
+        ResTableDelegate delegate(nullptr);
+        QImage image(400, 50, QImage::Format_ARGB32_Premultiplied);
+        QPainter painter(&image);
+        auto option = itemOption();
+        AllocCount::Scope scope;
+        for (int r = 0; r < rows; r++) {
+            delegate.paint(&painter, option, model->index(r));
+        }
+        QTest::setBenchmarkResult(scope.allocations(), QTest::Events);
+    }
+}
+
+QTEST_MAIN(ModelBench)
+
+#include "tst_modelbench.moc"
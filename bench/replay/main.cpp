@@ -0,0 +1,160 @@
+#include <cstdio>
+
+#include <DApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThreadPool>
+
+#include "config.h"
+#include "guiutils.h"
+#include "indexworker.h"
+#include "rclinit.h"
+#include "replayer.h"
+#include "synthcorpus.h"
+#include "textcache.h"
+#include "widget.h"
+
+static void recollCleanup() {
+    rcldb.reset();
+    deleteZ(theconfig);
+}
+
+// 复制随程序安装的 recoll_conf，把 topdirs 和 iconsdir 换成临时目录里的
+static bool writeConfig(const QString &confDir, const QString &topdir, QString *error) {
+    QDir src(RECOLL_CONF_TEMPLATE);
+    if (!QDir().mkpath(confDir + "/" + XAPIAN_DB_DIR)) {
+        *error = "cannot create " + confDir;
+        return false;
+    }
+    for (const auto &name : src.entryList(QDir::Files)) {
+        QFile in(src.absoluteFilePath(name));
+        QFile out(confDir + "/" + name);
+        if (!in.open(QIODevice::ReadOnly) || !out.open(QIODevice::WriteOnly)) {
+            *error = "cannot copy " + in.fileName();
+            return false;
+        }
+        auto data = QString::fromUtf8(in.readAll());
+        if (name == "recoll.conf") {
+            QStringList lines;
+            for (auto line : data.split('\n')) {
+                if (line.startsWith("topdirs")) {
+                    line = "topdirs = " + topdir;
+                } else if (line.startsWith("iconsdir")) {
+                    line = "iconsdir = " + src.absoluteFilePath("../icon");
+                }
+                lines << line;
+            }
+            data = lines.join('\n');
+        }
+        out.write(data.toUtf8());
+    }
+    return true;
+}
+
+static int fail(const QString &msg) {
+    fprintf(stderr, "replay: %s\n", msg.toUtf8().constData());
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    // 所有配置、索引和 desktop 文件都放在临时目录里，不碰用户自己的
+    QTemporaryDir tmp;
+    if (!tmp.isValid()) {
+        return fail("cannot create temporary directory");
+    }
+    auto root = tmp.path();
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    qputenv("HOME", QFile::encodeName(root + "/home"));
+    qputenv("XDG_CONFIG_HOME", QFile::encodeName(root + "/home/.config"));
+    qputenv("XDG_DATA_HOME", QFile::encodeName(root + "/home/.local/share"));
+    qputenv("XDG_CACHE_HOME", QFile::encodeName(root + "/home/.cache"));
+    qputenv("XDG_DATA_DIRS", QFile::encodeName(root + "/corpus/share"));
+
+    DApplication a(argc, argv);
+    DApplication::setApplicationName(AppName);
+    DApplication::setOrganizationName(AppName);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replay a keystroke trace against a synthetic index");
+    parser.addHelpOption();
+    QCommandLineOption docsOpt("docs", "Number of text documents.", "n", "2000");
+    QCommandLineOption appsOpt("apps", "Number of desktop files.", "n", "200");
+    QCommandLineOption seedOpt("seed", "Seed for the corpus and the generated trace.", "n", "1");
+    QCommandLineOption traceOpt("trace", "Recorded trace (EVERYLAUNCHER_KEYTRACE output).", "file");
+    QCommandLineOption queriesOpt("queries", "Queries in the generated trace.", "n", "50");
+    QCommandLineOption settleOpt("settle", "Wait after the last keystroke, in ms.", "ms", "2000");
+    QCommandLineOption keepOpt("keep", "Keep the temporary directory.");
+    parser.addOptions({docsOpt, appsOpt, seedOpt, traceOpt, queriesOpt, settleOpt, keepOpt});
+    parser.process(a);
+    if (parser.isSet(keepOpt)) {
+        tmp.setAutoRemove(false);
+        fprintf(stderr, "replay: keeping %s\n", root.toUtf8().constData());
+    }
+
+    SynthCorpus corpus(parser.value(seedOpt).toUInt());
+    QString error;
+    if (!corpus.generate(root + "/corpus", parser.value(docsOpt).toInt(),
+                         parser.value(appsOpt).toInt(), &error)) {
+        return fail(error);
+    }
+    auto confDir = QDir(QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation))
+                           .absoluteFilePath(RECOLL_CONFIG_DIR);
+    if (!writeConfig(confDir, root + "/corpus/docs", &error)) {
+        return fail(error);
+    }
+
+    std::string reason;
+    auto confg = confDir.toStdString();
+    theconfig = recollinit(0, recollCleanup, nullptr, reason, &confg);
+    if (!theconfig || !theconfig->ok()) {
+        return fail("configuration problem: " + QString::fromStdString(reason));
+    }
+    TextCache::instance()->setLocation(QString::fromStdString(theconfig->getDbDir()));
+    rwSettings(false);
+
+    // 同步建好索引，结束后释放写锁，界面里的 IndexWorker 才能再打开
+    {
+        QElapsedTimer timer;
+        timer.start();
+        IndexWorker worker(theconfig);
+        worker.indexAll(false);
+        fprintf(stderr, "replay: indexed %d docs and %d apps in %lld ms\n",
+                parser.value(docsOpt).toInt(), parser.value(appsOpt).toInt(),
+                timer.elapsed());
+    }
+    if (!maybeOpenDb(reason, true, nullptr)) {
+        return fail(QString::fromStdString(reason));
+    }
+
+    QVector<TraceEvent> trace;
+    if (parser.isSet(traceOpt)) {
+        trace = Replayer::load(parser.value(traceOpt), &error);
+        if (trace.isEmpty()) {
+            return fail(error.isEmpty() ? "empty trace" : error);
+        }
+    } else {
+        trace = corpus.makeTrace(parser.value(queriesOpt).toInt());
+    }
+
+    MainWindow w;
+    w.show();
+    w.setBackendReady();
+    // 等路径索引、词典等后台任务完成，不算进第一次查询
+    QThreadPool::globalInstance()->waitForDone();
+    a.processEvents();
+
+    Replayer replayer(&w, trace, parser.value(settleOpt).toLongLong());
+    QObject::connect(&replayer, &Replayer::finished, &a, [&replayer]() {
+        printf("%s\n", replayer.report().toUtf8().constData());
+        qApp->quit();
+    });
+    replayer.start();
+    return a.exec();
+}
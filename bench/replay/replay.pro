@@ -0,0 +1,22 @@
+# 按键重放：生成确定的合成索引和 desktop 文件，重放按键记录，
+# 统计每次按键到出现结果、到结果稳定的延迟。不需要 X：
+#   ./replay --docs 5000 --apps 300 [--trace keys.jsonl]
+# 按键记录可以用 EVERYLAUNCHER_KEYTRACE=keys.jsonl everylauncher 录制
+TARGET = replay
+TEMPLATE = app
+QT += testlib
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../../src/everylauncher.pri)
+
+DEFINES += RECOLL_CONF_TEMPLATE=\\\"$$PWD/../../recoll_conf\\\"
+
+SOURCES += \
+    main.cpp \
+    synthcorpus.cpp \
+    replayer.cpp
+
+HEADERS += \
+    synthcorpus.h \
+    replayer.h
@@ -0,0 +1,184 @@
+#include "replayer.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLineEdit>
+#include <QStringList>
+#include <QTest>
+#include <QTimer>
+
+#include <algorithm>
+#include <cmath>
+
+#include "reslistwidget.h"
+#include "searchline.h"
+#include "widget.h"
+
+Replayer::Replayer(MainWindow *window, QVector<TraceEvent> trace, qint64 settleMs,
+                   QObject *parent)
+    : QObject(parent), m_window(window), m_trace(std::move(trace)), m_settleMs(settleMs)
+{
+    m_line = window->findChild<SearchWidget *>()->findChild<QLineEdit *>();
+    auto model = window->findChild<ResTable *>()->getModel();
+    connect(window, &MainWindow::searchStarted, this, &Replayer::onSearchStarted);
+    connect(window, &MainWindow::searchDropped, this, [this]() { m_dropped++; });
+    connect(model, &RecollModel::resultCountChanged, this,
+            [this](int shown, int) { onResults(shown); });
+}
+
+QVector<TraceEvent> Replayer::load(const QString &path, QString *error)
+{
+    QVector<TraceEvent> trace;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = file.errorString();
+        return trace;
+    }
+    int lineNo = 0;
+    while (!file.atEnd()) {
+        lineNo++;
+        auto line = file.readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        auto obj = QJsonDocument::fromJson(line).object();
+        if (!obj.contains("t") || !obj.contains("text")) {
+            *error = QString("%1:%2: expected {\"t\": ms, \"text\": ...}").arg(path).arg(lineNo);
+            return QVector<TraceEvent>();
+        }
+        trace.append({qint64(obj["t"].toDouble()), obj["text"].toString()});
+    }
+    // 录制时的时间从程序启动算起
+    if (!trace.isEmpty()) {
+        auto base = trace.first().t;
+        for (auto &ev : trace) {
+            ev.t -= base;
+        }
+    }
+    return trace;
+}
+
+void Replayer::start()
+{
+    m_keys.clear();
+    for (const auto &ev : m_trace) {
+        Keystroke key;
+        key.planned = ev.t;
+        key.cleared = ev.text.trimmed().size() < 2;
+        m_keys.append(key);
+    }
+    m_line->setFocus();
+    m_clock.start();
+    // 所有按键一开始就排好，查询阻塞时在嵌套的事件循环里照常触发
+    for (int i = 0; i < m_trace.size(); i++) {
+        QTimer::singleShot(int(m_trace[i].t), Qt::PreciseTimer, this, [this, i]() { apply(i); });
+    }
+    auto end = m_trace.isEmpty() ? 0 : m_trace.last().t;
+    QTimer::singleShot(int(end + m_settleMs), this, &Replayer::finished);
+}
+
+void Replayer::apply(int i)
+{
+    m_current = i;
+    m_keys[i].applied = m_clock.elapsed();
+    auto current = m_line->text();
+    const auto &target = m_trace[i].text;
+    m_line->end(false);
+    // 只差一个 ASCII 字符时按真实的按键发送，经过补全等完整的路径；
+    // 其它变化（粘贴、全选删除、中文输入）直接设置文字
+    if (target.size() == current.size() + 1 && target.startsWith(current) &&
+        target.back().unicode() < 128 && target.back().isPrint()) {
+        QTest::keyClick(m_line, target.back().toLatin1());
+    } else if (target.size() + 1 == current.size() && current.startsWith(target)) {
+        QTest::keyClick(m_line, Qt::Key_Backspace);
+    } else if (target != current) {
+        m_line->setText(target);
+    }
+}
+
+void Replayer::onSearchStarted()
+{
+    // fuzzyRetry 为同一次按键再查一次，算作同一次查询
+    if (!m_searches.isEmpty() && m_searches.last().keystroke == m_current) {
+        return;
+    }
+    m_searches.append({m_current});
+}
+
+void Replayer::onResults(int shown)
+{
+    if (m_searches.isEmpty()) {
+        return;
+    }
+    auto &search = m_searches.last();
+    // 输入被清空后结果列表也清空，不属于之前的查询
+    if (m_current >= 0 && m_keys[m_current].cleared && search.keystroke < m_current) {
+        return;
+    }
+    auto now = m_clock.elapsed();
+    if (shown > 0 && search.first < 0) {
+        search.first = now;
+    }
+    search.last = now;
+}
+
+// 最近秩法
+static qint64 percentile(QVector<qint64> values, double p)
+{
+    if (values.isEmpty()) {
+        return -1;
+    }
+    std::sort(values.begin(), values.end());
+    auto idx = int(std::ceil(p / 100.0 * values.size())) - 1;
+    return values[qBound(0, idx, values.size() - 1)];
+}
+
+QString Replayer::report() const
+{
+    QVector<qint64> lag, first, stable;
+    int searchable = 0, coalesced = 0, unanswered = 0;
+    for (int i = 0; i < m_keys.size(); i++) {
+        const auto &key = m_keys[i];
+        if (key.applied >= 0) {
+            lag.append(key.applied - key.planned);
+        }
+        if (key.cleared) {
+            continue;
+        }
+        searchable++;
+        auto it = std::find_if(m_searches.begin(), m_searches.end(),
+                               [i](const Search &s) { return s.keystroke >= i; });
+        if (it == m_searches.end() || it->last < 0) {
+            unanswered++;
+            continue;
+        }
+        if (it->keystroke > i) {
+            coalesced++;
+        }
+        first.append((it->first >= 0 ? it->first : it->last) - key.planned);
+        stable.append(it->last - key.planned);
+    }
+
+    QStringList lines;
+    lines << QString("keystrokes      %1 (searchable %2, cleared %3)")
+                     .arg(m_keys.size()).arg(searchable).arg(m_keys.size() - searchable);
+    lines << QString("searches        %1 started, %2 dropped")
+                     .arg(m_searches.size()).arg(m_dropped);
+    lines << QString("keystrokes      %1 coalesced, %2 unanswered")
+                     .arg(coalesced).arg(unanswered);
+    lines << QString("%1 %2 %3 %4 %5   (ms)")
+                     .arg("", -16).arg("p50", 8).arg("p95", 8).arg("p99", 8).arg("max", 8);
+    auto row = [&lines](const QString &name, const QVector<qint64> &values) {
+        lines << QString("%1 %2 %3 %4 %5")
+                         .arg(name, -16)
+                         .arg(percentile(values, 50), 8)
+                         .arg(percentile(values, 95), 8)
+                         .arg(percentile(values, 99), 8)
+                         .arg(percentile(values, 100), 8);
+    };
+    row("input lag", lag);
+    row("first result", first);
+    row("stable result", stable);
+    return lines.join("\n");
+}
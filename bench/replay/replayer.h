@@ -0,0 +1,72 @@
+#ifndef REPLAYER_H
+#define REPLAYER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+class MainWindow;
+class QLineEdit;
+
+// 按键记录的一行：相对开始的毫秒数和这次按键后输入框的文字
+struct TraceEvent {
+    qint64 t;
+    QString text;
+};
+
+/*
+ * 按记录的时间把输入框的变化送给 SearchWidget，和真实输入一样经过
+ * SearchWidget -> MainWindow::startSearch -> RecollModel。
+ * 查询阻塞界面线程时定时器在嵌套的事件循环里触发，这时的按键会被丢弃，和真实情况相同。
+ *
+ * 每次按键的延迟按它之后开始的第一次查询计算：
+ * 第一次出现结果（有行）和最后一次更新结果（包括迟到的其它来源）的时间。
+ * 这次查询是为后面的按键开始的，就算这次按键被合并了。
+ */
+class Replayer : public QObject
+{
+    Q_OBJECT
+public:
+    Replayer(MainWindow *window, QVector<TraceEvent> trace, qint64 settleMs,
+             QObject *parent = nullptr);
+
+    // 每行一个 {"t": 毫秒, "text": "..."}
+    static QVector<TraceEvent> load(const QString &path, QString *error);
+
+    void start();
+    QString report() const;
+
+signals:
+    void finished();
+
+private:
+    void apply(int i);
+    void onSearchStarted();
+    void onResults(int shown);
+
+private:
+    struct Keystroke {
+        qint64 planned;
+        qint64 applied{-1};
+        // 少于两个字符时不查询，只清空结果
+        bool cleared{false};
+    };
+    struct Search {
+        int keystroke;
+        qint64 first{-1};
+        qint64 last{-1};
+    };
+
+    MainWindow *m_window;
+    QLineEdit *m_line;
+    QVector<TraceEvent> m_trace;
+    qint64 m_settleMs;
+    QElapsedTimer m_clock;
+    QVector<Keystroke> m_keys;
+    QVector<Search> m_searches;
+    int m_current{-1};
+    int m_dropped{0};
+};
+
+#endif // REPLAYER_H
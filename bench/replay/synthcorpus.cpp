@@ -0,0 +1,140 @@
+#include "synthcorpus.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSet>
+#include <QTextStream>
+
+#include <cmath>
+
+static const int vocabSize = 3000;
+
+SynthCorpus::SynthCorpus(quint32 seed) : m_rng(seed)
+{
+    static const char *const syllables[] = {
+        "ka", "ro", "mi", "te", "lu", "san", "dor", "vi", "pe", "nal",
+        "qua", "bel", "tor", "fi", "gen", "mo", "ris", "da", "len", "cu",
+        "ex", "po", "zan", "hel", "tri", "ob", "ur", "sta", "ni", "val",
+    };
+    const int n = int(sizeof(syllables) / sizeof(syllables[0]));
+    QSet<QString> seen;
+    while (m_vocab.size() < vocabSize) {
+        QString w;
+        int parts = uniform(2, 4);
+        for (int i = 0; i < parts; i++) {
+            w += syllables[uniform(0, n - 1)];
+        }
+        if (!seen.contains(w)) {
+            seen.insert(w);
+            m_vocab << w;
+        }
+    }
+}
+
+int SynthCorpus::uniform(int lo, int hi)
+{
+    return std::uniform_int_distribution<int>(lo, hi)(m_rng);
+}
+
+// 近似 Zipf：小编号的词取到的概率大得多
+QString SynthCorpus::word()
+{
+    double u = std::uniform_real_distribution<double>(0.0, 1.0)(m_rng);
+    int idx = int(std::pow(u, 3.0) * m_vocab.size());
+    return m_vocab[qMin(idx, m_vocab.size() - 1)];
+}
+
+QString SynthCorpus::sentence(int words)
+{
+    QStringList out;
+    for (int i = 0; i < words; i++) {
+        out << word();
+    }
+    return out.join(' ');
+}
+
+bool SynthCorpus::generate(const QString &root, int docs, int apps, QString *error)
+{
+    QDir base(root);
+    for (int i = 0; i < docs; i++) {
+        auto dir = QString("docs/d%1").arg(i / 100, 3, 10, QChar('0'));
+        if (!base.mkpath(dir)) {
+            *error = "cannot create " + base.absoluteFilePath(dir);
+            return false;
+        }
+        auto name = QString("%1/%2-%3.txt").arg(dir).arg(word()).arg(i);
+        QFile file(base.absoluteFilePath(name));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            *error = file.errorString();
+            return false;
+        }
+        QTextStream out(&file);
+        out << sentence(uniform(3, 8)) << "\n\n";
+        int words = uniform(80, 300);
+        while (words > 0) {
+            int n = qMin(words, uniform(8, 20));
+            out << sentence(n) << ".\n";
+            words -= n;
+        }
+    }
+
+    if (!base.mkpath("share/applications")) {
+        *error = "cannot create " + base.absoluteFilePath("share/applications");
+        return false;
+    }
+    m_appNames.clear();
+    for (int i = 0; i < apps; i++) {
+        auto name = word();
+        name[0] = name[0].toUpper();
+        if (uniform(0, 2) == 0) {
+            name += " " + word();
+        }
+        m_appNames << name;
+        QFile file(base.absoluteFilePath(QString("share/applications/synth-%1.desktop").arg(i)));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            *error = file.errorString();
+            return false;
+        }
+        QTextStream out(&file);
+        out << "[Desktop Entry]\n"
+            << "Type=Application\n"
+            << "Name=" << name << "\n"
+            << "Comment=" << sentence(uniform(3, 7)) << "\n"
+            << "Exec=/bin/true\n"
+            << "Icon=synth-" << i << "\n";
+    }
+    return true;
+}
+
+QVector<TraceEvent> SynthCorpus::makeTrace(int queries)
+{
+    QVector<TraceEvent> trace;
+    qint64 t = 0;
+    for (int q = 0; q < queries; q++) {
+        // 大约三分之一搜程序，其余搜文档里的词
+        QString target;
+        if (!m_appNames.isEmpty() && uniform(0, 2) == 0) {
+            target = m_appNames[uniform(0, m_appNames.size() - 1)].toLower();
+        } else {
+            target = uniform(0, 3) == 0 ? word() + " " + word() : word();
+        }
+        // 一般不会输完整个词
+        int len = qMin(target.size(), uniform(3, 8) + (target.contains(' ') ? 4 : 0));
+        QString text;
+        for (int i = 0; i < len; i++) {
+            if (uniform(0, 19) == 0) {
+                t += uniform(60, 200);
+                trace.append({t, text + QChar('a' + uniform(0, 25))});
+                t += uniform(150, 350);
+                trace.append({t, text});
+            }
+            text += target[i];
+            t += uniform(60, 200);
+            trace.append({t, text});
+        }
+        t += uniform(800, 1500);
+        trace.append({t, QString()});
+        t += uniform(200, 500);
+    }
+    return trace;
+}
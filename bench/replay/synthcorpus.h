@@ -0,0 +1,39 @@
+#ifndef SYNTHCORPUS_H
+#define SYNTHCORPUS_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <random>
+
+#include "replayer.h"
+
+/*
+ * 确定的合成数据：同一个种子每次生成完全相同的文档、desktop 文件和按键记录。
+ * 词表由音节拼成，按偏斜的分布取词，常用词在很多文档里出现，
+ * 这样前缀查询既有结果很多的也有很少的。
+ */
+class SynthCorpus
+{
+public:
+    explicit SynthCorpus(quint32 seed);
+
+    // 在 root/docs 下生成文本文件，在 root/share/applications 下生成 desktop 文件
+    bool generate(const QString &root, int docs, int apps, QString *error);
+
+    // queries 次输入：逐字输入一两个词的前缀，偶尔打错再退格，停顿后清空
+    QVector<TraceEvent> makeTrace(int queries);
+
+private:
+    QString word();
+    QString sentence(int words);
+    int uniform(int lo, int hi);
+
+private:
+    std::mt19937 m_rng;
+    QStringList m_vocab;
+    QStringList m_appNames;
+};
+
+#endif // SYNTHCORPUS_H
@@ -1,5 +1,6 @@
 #!/usr/bin/env python3
 import sys
+from html import escape
 from pypinyin import lazy_pinyin
 import os
 
@@ -40,6 +41,11 @@ def main(args):
     AppIcon=ip
 
 
+    # 启动器直接用这一行启动，不用再解析 desktop 文件
+    AppExec=desktop.getExec()
+    if desktop.getTerminal():
+        AppExec="x-terminal-emulator -e "+AppExec
+
     NoDisplay=desktop.getNoDisplay()
     onlydi=desktop.getOnlyShowIn()
 
@@ -47,6 +53,7 @@ def main(args):
         AppIcon=""
         AppName=""
         AppComment=""
+        AppExec=""
         NoDisplay="true"
     else:
         NoDisplay="false"
@@ -63,6 +70,7 @@ def main(args):
 <meta name="AppComment" content="'''+AppComment+'''" />
 <meta name="AppIcon" content="'''+AppIcon+'''" />
 <meta name="AppNoDisplay" content="'''+NoDisplay+'''" />
+<meta name="AppExec" content="'''+escape(AppExec)+'''" />
 
 </head>
 <body>
@@ -0,0 +1,145 @@
+#include <cstdio>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QThreadPool>
+
+#include <memory>
+#include <vector>
+
+#include "config.h"
+#include "fuzzyindex.h"
+#include "guiutils.h"
+#include "pathindex.h"
+#include "querytrace.h"
+#include "rclinit.h"
+#include "searchengine.h"
+#include "termdict.h"
+
+static void recollCleanup() {
+    rcldb.reset();
+    deleteZ(theconfig);
+}
+
+static int fail(const QString &msg) {
+    fprintf(stderr, "everylauncher-query: %s\n", msg.toUtf8().constData());
+    return 1;
+}
+
+static void printDoc(const Rcl::Doc &doc, bool json, const QString &stage) {
+    auto map = SearchEngine::toVariant(doc);
+    if (json) {
+        if (!stage.isEmpty()) {
+            map["stage"] = stage;
+        }
+        auto line = QJsonDocument(QJsonObject::fromVariantMap(map)).toJson(QJsonDocument::Compact);
+        printf("%s\n", line.constData());
+        return;
+    }
+    printf("%s\t%s\t%s\n", map["title"].toString().toUtf8().constData(),
+           map["group"].toString().toUtf8().constData(),
+           map["url"].toString().toUtf8().constData());
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication a(argc, argv);
+    // 和启动器用同一个配置目录
+    QCoreApplication::setApplicationName(AppName);
+    QCoreApplication::setOrganizationName(AppName);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Search the EveryLauncher index without the GUI");
+    parser.addHelpOption();
+    QCommandLineOption limitOpt("limit", "Maximum number of results.", "n", "20");
+    QCommandLineOption jsonOpt("json", "One JSON object per result.");
+    QCommandLineOption streamOpt("stream", "Print every batch as it arrives.");
+    QCommandLineOption timingOpt("timing", "Print the time of every batch to stderr.");
+    QCommandLineOption traceOpt("trace", "Write a Chrome trace of the query.", "file");
+    parser.addOptions({limitOpt, jsonOpt, streamOpt, timingOpt, traceOpt});
+    parser.addPositionalArgument("query", "Words to search for, as typed in the launcher.");
+    parser.process(a);
+    auto text = parser.positionalArguments().join(' ').trimmed();
+    if (text.isEmpty()) {
+        parser.showHelp(1);
+    }
+    int limit = parser.value(limitOpt).toInt();
+    if (limit <= 0) {
+        return fail("--limit must be a positive number");
+    }
+    bool json = parser.isSet(jsonOpt);
+    bool stream = parser.isSet(streamOpt);
+    bool timing = parser.isSet(timingOpt);
+
+    QElapsedTimer timer;
+    timer.start();
+    auto confDir = QDir(QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation))
+                           .absoluteFilePath(RECOLL_CONFIG_DIR);
+    if (!QDir(confDir).exists()) {
+        return fail("no configuration in " + confDir + ", start everylauncher once first");
+    }
+    std::string reason;
+    auto confg = confDir.toStdString();
+    theconfig = recollinit(0, recollCleanup, nullptr, reason, &confg);
+    if (!theconfig || !theconfig->ok()) {
+        return fail("configuration problem: " + QString::fromStdString(reason));
+    }
+    // 读取 recoll 界面设置，比如查询的词干语言
+    rwSettings(false);
+    if (!maybeOpenDb(reason, true, nullptr)) {
+        return fail(QString::fromStdString(reason));
+    }
+    // 启动器上次导出的词典和路径索引，这里不重建
+    if (TermDict::instance()->open(TermDict::defaultPath())) {
+        FuzzyIndex::instance()->rebuild();
+    }
+    auto pathIndex = std::make_shared<PathIndex>();
+    pathIndex->open();
+    SearchEngine::registerProviders(pathIndex);
+    // 等程序索引和容错词表建好
+    QThreadPool::globalInstance()->waitForDone();
+    if (timing) {
+        fprintf(stderr, "# startup: %lld ms\n", timer.elapsed());
+    }
+
+    if (parser.isSet(traceOpt)) {
+        QueryTrace::beginQuery(text);
+    }
+    timer.restart();
+    std::vector<Rcl::Doc> shown;
+    QString error;
+    bool ok = SearchEngine::search(rcldb, text, limit,
+                                   [&](const SearchEngine::Batch &batch) {
+        if (timing) {
+            fprintf(stderr, "# %s: %d results at %lld ms\n", batch.stage.toUtf8().constData(),
+                    int(batch.docs.size()), timer.elapsed());
+        }
+        if (stream) {
+            for (const auto &doc : batch.docs) {
+                printDoc(doc, json, batch.stage);
+            }
+            fflush(stdout);
+            return;
+        }
+        if (batch.stage != "late") {
+            shown.clear();
+        }
+        shown.insert(shown.end(), batch.docs.begin(), batch.docs.end());
+    }, &error);
+    if (!ok) {
+        return fail(error);
+    }
+    for (const auto &doc : shown) {
+        printDoc(doc, json, QString());
+    }
+    if (parser.isSet(traceOpt)) {
+        QueryTrace::endQuery();
+        auto written = QueryTrace::dump(parser.value(traceOpt));
+        fprintf(stderr, "# trace: %s\n", written.toUtf8().constData());
+    }
+    return 0;
+}
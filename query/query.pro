@@ -0,0 +1,14 @@
+# everylauncher-query：用和启动器相同的查询流程查已有的索引，不需要界面和 X
+#   everylauncher-query [--limit 20] [--json] [--stream] [--timing] [--trace out.json] 查询词...
+TARGET = everylauncher-query
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../src/engine.pri)
+
+SOURCES += main.cpp
+
+isEmpty(PREFIX): PREFIX = /usr
+target.path = $$PREFIX/bin
+INSTALLS += target
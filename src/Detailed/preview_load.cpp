@@ -22,6 +22,7 @@
 #include "rcldoc.h"
 #include "pathut.h"
 #include "rclconfig.h"
+#include "textcache.h"
 
 LoadThread::LoadThread(RclConfig *config, const Rcl::Doc& idc,
                        bool pvhtm, QObject *parent)
@@ -32,6 +33,14 @@ LoadThread::LoadThread(RclConfig *config, const Rcl::Doc& idc,
 
 void LoadThread::run()
 {
+    // Converted text is cached after the first preview, so that we
+    // don't have to run the external filter again.
+    if (TextCache::instance()->get(m_idoc, m_previewHtml, fdoc)) {
+        LOGDEB("LoadThread: text cache hit for " << m_idoc.url << "\n");
+        status = 0;
+        return;
+    }
+
     FileInterner interner(m_idoc, &m_config, FileInterner::FIF_forPreview);
     FIMissingStore mst;
     interner.setMissingStore(&mst);
@@ -57,6 +66,9 @@ void LoadThread::run()
                 fdoc.mimetype = "text/html";
             }
             tmpimg = interner.get_imgtmp();
+            if (!tmpimg.ok()) {
+                TextCache::instance()->put(m_idoc, m_previewHtml, fdoc);
+            }
         } else {
             fdoc.mimetype = interner.getMimetype();
             mst.getMissingExternal(missing);
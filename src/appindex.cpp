@@ -0,0 +1,266 @@
+#include "appindex.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QIcon>
+#include <QMutexLocker>
+#include <QSet>
+#include <QtConcurrent>
+#include <XdgDesktopFile>
+#include <XdgDirs>
+#include <dpinyin.h>
+
+#include <algorithm>
+
+DCORE_USE_NAMESPACE
+
+// 最多返回的应用数
+static const int maxResults = 8;
+static const int rebuildDelayMs = 2000;
+
+AppIndex::AppIndex(QObject *parent) : QObject(parent)
+{
+    m_watcher = new QFileSystemWatcher(this);
+    m_rebuildTimer = new QTimer(this);
+    m_rebuildTimer->setSingleShot(true);
+    m_rebuildTimer->setInterval(rebuildDelayMs);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, m_rebuildTimer,
+            static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(m_rebuildTimer, &QTimer::timeout, this, &AppIndex::rebuild);
+    rebuild();
+}
+
+QStringList AppIndex::applicationDirs()
+{
+    // 按优先级从高到低，同一个 desktop id 只用第一个
+    QStringList dirs;
+    dirs << XdgDirs::dataHome() + "/applications";
+    for (const auto &d : XdgDirs::dataDirs()) {
+        dirs << d + "/applications";
+    }
+    return dirs;
+}
+
+QString AppIndex::findIcon(const QString &icon)
+{
+    if (icon.isEmpty()) {
+        return QString();
+    }
+    if (QFileInfo(icon).isAbsolute()) {
+        return QFileInfo::exists(icon) ? icon : QString();
+    }
+    static const char *sizes[] = {"48x48", "64x64", "scalable", "128x128", "256x256", "32x32"};
+    static const char *exts[] = {"png", "svg", "xpm"};
+    QStringList bases;
+    bases << XdgDirs::dataHome() + "/icons";
+    for (const auto &d : XdgDirs::dataDirs()) {
+        bases << d + "/icons";
+    }
+    QStringList themes;
+    themes << QIcon::themeName() << "hicolor";
+    for (const auto &base : bases) {
+        for (const auto &theme : themes) {
+            for (auto size : sizes) {
+                for (auto ext : exts) {
+                    auto path = QString("%1/%2/%3/apps/%4.%5").arg(base, theme, size, icon, ext);
+                    if (QFileInfo::exists(path)) {
+                        return path;
+                    }
+                }
+            }
+        }
+    }
+    for (auto ext : exts) {
+        auto path = QString("/usr/share/pixmaps/%1.%2").arg(icon, ext);
+        if (QFileInfo::exists(path)) {
+            return path;
+        }
+    }
+    return QString();
+}
+
+// 和 rcldesktop.py 里的 lazy_pinyin 一样，汉字换成不带声调的拼音，其它字符不变。
+// 没有汉字时返回空
+static QString toPinyin(const QString &name)
+{
+    QString out;
+    bool han = false;
+    for (auto c : name) {
+        if (c.script() != QChar::Script_Han) {
+            out += c.toLower();
+            continue;
+        }
+        // Chinese2Pinyin 在每个音节后面加上声调数字
+        auto py = Chinese2Pinyin(QString(c));
+        while (!py.isEmpty() && py.back().isDigit()) {
+            py.chop(1);
+        }
+        out += py.toLower();
+        han = true;
+    }
+    return han ? out : QString();
+}
+
+std::shared_ptr<AppIndex::Table> AppIndex::build(const QStringList &dirs)
+{
+    auto table = std::make_shared<Table>();
+    QSet<QString> seen;
+    for (const auto &dir : dirs) {
+        QDirIterator it(dir, QStringList() << "*.desktop", QDir::Files,
+                        QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            auto path = it.next();
+            // desktop id：相对路径中的 / 换成 -
+            auto id = path.mid(dir.size() + 1).replace('/', '-');
+            if (seen.contains(id)) {
+                continue;
+            }
+            seen.insert(id);
+            XdgDesktopFile df;
+            if (!df.load(path) || !df.isValid() || df.type() != XdgDesktopFile::ApplicationType ||
+                !df.isShown()) {
+                continue;
+            }
+            App app;
+            app.path = path;
+            app.name = df.name();
+            app.comment = df.comment();
+            app.iconPath = findIcon(df.iconName());
+            app.exec = df.value("Exec").toString();
+            // 和 rcldesktop.py 一样，终端程序用 x-terminal-emulator 包一层
+            if (df.value("Terminal").toBool()) {
+                app.exec = "x-terminal-emulator -e " + app.exec;
+            }
+            app.lowerName = app.name.toLower();
+            app.lowerOther << df.localizedValue("GenericName").toString().toLower()
+                           << df.value("Name").toString().toLower()
+                           << QFileInfo(app.exec.split(' ').value(0)).fileName().toLower()
+                           << id.toLower();
+            auto pinyin = toPinyin(app.name);
+            if (!pinyin.isEmpty()) {
+                app.lowerOther << pinyin;
+            }
+            for (const auto &kw : df.localizedValue("Keywords").toString().split(';', QString::SkipEmptyParts)) {
+                app.lowerOther << kw.toLower();
+            }
+            table->apps.push_back(std::move(app));
+        }
+    }
+    return table;
+}
+
+void AppIndex::watch(const QStringList &dirs)
+{
+    QStringList wanted;
+    for (const auto &dir : dirs) {
+        if (!QFileInfo(dir).isDir()) {
+            continue;
+        }
+        wanted << dir;
+        QDirIterator it(dir, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            wanted << it.next();
+        }
+    }
+    auto current = m_watcher->directories();
+    for (const auto &dir : current) {
+        if (!wanted.contains(dir)) {
+            m_watcher->removePath(dir);
+        }
+    }
+    for (const auto &dir : wanted) {
+        if (!current.contains(dir)) {
+            m_watcher->addPath(dir);
+        }
+    }
+}
+
+void AppIndex::rebuild()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_building) {
+            // 正在建的完成后再来一次
+            m_rebuildTimer->start();
+            return;
+        }
+        m_building = true;
+    }
+    auto dirs = applicationDirs();
+    watch(dirs);
+    QtConcurrent::run([this, dirs]() {
+        QElapsedTimer timer;
+        timer.start();
+        auto table = build(dirs);
+        qDebug() << "AppIndex:" << table->apps.size() << "apps in" << timer.elapsed() << "ms";
+        QMutexLocker locker(&m_mutex);
+        m_table = table;
+        m_building = false;
+    });
+}
+
+std::shared_ptr<const AppIndex::Table> AppIndex::table() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_table;
+}
+
+std::vector<Rcl::Doc> AppIndex::query(const QString &text, int)
+{
+    std::vector<Rcl::Doc> docs;
+    auto t = table();
+    auto words = text.toLower().split(' ', QString::SkipEmptyParts);
+    if (!t || words.isEmpty()) {
+        return docs;
+    }
+    std::vector<std::pair<int, const App *>> hits;
+    auto whole = words.join(' ');
+    for (const auto &app : t->apps) {
+        int score = 0;
+        if (app.lowerName.startsWith(whole)) {
+            score = 100;
+        } else if (app.lowerName.contains(' ' + words.first())) {
+            // 名字中某个词的开头
+            score = 90;
+        }
+        bool all = true;
+        bool inName = true;
+        for (const auto &w : words) {
+            if (app.lowerName.contains(w)) {
+                continue;
+            }
+            inName = false;
+            if (!std::any_of(app.lowerOther.begin(), app.lowerOther.end(),
+                             [&w](const QString &s) { return s.contains(w); })) {
+                all = false;
+                break;
+            }
+        }
+        if (!all) {
+            continue;
+        }
+        if (score == 0) {
+            score = inName ? 80 : 60;
+        }
+        hits.push_back({score, &app});
+    }
+    std::stable_sort(hits.begin(), hits.end(),
+                     [](const std::pair<int, const App *> &a, const std::pair<int, const App *> &b) {
+                         return a.first > b.first;
+                     });
+    for (int i = 0; i < int(hits.size()) && i < maxResults; i++) {
+        const auto &app = *hits[i].second;
+        auto doc = makeDoc("file://" + app.path, "application/x-all", app.name, app.comment,
+                           hits[i].first);
+        doc.meta["appname"] = app.name.toStdString();
+        doc.meta["appcomment"] = app.comment.toStdString();
+        doc.meta["appicon"] = app.iconPath.toStdString();
+        doc.meta["appexec"] = app.exec.toStdString();
+        doc.meta["appnodisplay"] = "false";
+        docs.push_back(std::move(doc));
+    }
+    return docs;
+}
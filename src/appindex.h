@@ -0,0 +1,60 @@
+#ifndef APPINDEX_H
+#define APPINDEX_H
+
+#include "searchprovider.h"
+
+#include <QFileSystemWatcher>
+#include <QMutex>
+#include <QObject>
+#include <QTimer>
+
+#include <memory>
+#include <vector>
+
+/*
+ * 应用程序的内存索引，代替把 /usr/share/applications 放进 recoll 的 topdirs。
+ * 启动时在后台扫描所有 applications 目录，只有这些目录变化时才重建，
+ * 和文档索引互不影响。作为第一个 SearchProvider 和 recoll 查询并行。
+ */
+class AppIndex : public QObject, public SearchProvider
+{
+    Q_OBJECT
+public:
+    explicit AppIndex(QObject *parent = nullptr);
+
+    QString name() const override { return "apps"; }
+    std::vector<Rcl::Doc> query(const QString &text, int budgetMs) override;
+
+    void rebuild();
+
+private:
+    struct App {
+        QString path;
+        QString name;
+        QString comment;
+        QString iconPath;
+        QString exec;
+        // 小写的名字、通用名、关键字、可执行文件名、中文名的拼音，用来匹配
+        QString lowerName;
+        QStringList lowerOther;
+    };
+    struct Table {
+        std::vector<App> apps;
+    };
+
+    static QStringList applicationDirs();
+    static QString findIcon(const QString &icon);
+    static std::shared_ptr<Table> build(const QStringList &dirs);
+    void watch(const QStringList &dirs);
+    std::shared_ptr<const Table> table() const;
+
+private:
+    mutable QMutex m_mutex;
+    std::shared_ptr<const Table> m_table;
+    bool m_building{false};
+    QFileSystemWatcher *m_watcher;
+    // 安装软件时目录会连续变化多次，合并成一次重建
+    QTimer *m_rebuildTimer;
+};
+
+#endif // APPINDEX_H
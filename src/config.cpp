@@ -0,0 +1,37 @@
+#include "config.h"
+
+#include <rcldb.h>
+
+const QString AppName = "EveryLauncher";
+const QString RECOLL_CONFIG_DIR = "recoll_conf";
+const QString RECOLL_CONFIG_FILE = "recoll.conf";
+const QString XAPIAN_DB_DIR = "xapiandb";
+const QString DBUS_SERVICE = "com.gitee.wanywhn.EveryLauncher";
+const QString DBUS_PATH = "/com/gitee/wanywhn/EveryLauncher";
+// QString DBUS_INTERFACE="com.gitee.wanywhn.EveryLauncher";
+const QString ORGANIZATION_NAME = "WANYWHN";
+
+const QString DBUS_MONITOR_SERVER ="com.gitee.wanywhn.EveryLauncherMonitor";
+const QString DBUS_MONITOR_PATH ="/com/gitee/wanywhn/EveryLauncherMonitor";
+//#define DBUS_INTERFACE "com.gitee.wanywhn.everylauncherMonitor"
+RclConfig *theconfig;
+std::shared_ptr<Rcl::Db> rcldb;
+
+bool maybeOpenDb(std::string &reason, bool force, bool *maindberror) {
+
+    if (force) {
+        rcldb = std::make_shared<Rcl::Db>(theconfig);
+    }
+    rcldb->rmQueryDb("");
+    Rcl::Db::OpenError error;
+    if (!rcldb->isopen() && !rcldb->open(Rcl::Db::DbRO, &error)) {
+        reason = "Could not open database";
+        if (maindberror) {
+            reason +=
+                    " in " + theconfig->getDbDir() + " wait for indexing to complete?";
+            *maindberror = error == Rcl::Db::DbOpenMainDb;
+        }
+        return false;
+    }
+    return true;
+}
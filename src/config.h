@@ -4,8 +4,16 @@
 #include <QString>
 #include <rclconfig.h>
 
+#include <memory>
+#include <string>
+
+namespace Rcl {
+class Db;
+}
+
 
 extern RclConfig *theconfig;
+extern std::shared_ptr<Rcl::Db> rcldb;
 extern const QString AppName;
 extern const QString RECOLL_CONFIG_DIR;
 extern const QString XAPIAN_DB_DIR;
@@ -17,4 +25,13 @@ extern const QString RECOLL_CONFIG_FILE;
 extern const QString DBUS_MONITOR_SERVER;
 extern const QString DBUS_MONITOR_PATH;
 
+/**
+ * 打开数据库
+ * @param reason 传出错误用参数
+ * @param force 是否强制重新打开
+ * @param maindberror 是否返回是主数据库打开错误
+ * @return
+ */
+bool maybeOpenDb(std::string &reason, bool force, bool *maindberror);
+
 #endif // CONFIG_H
@@ -1,10 +1,20 @@
 #include <utility>
 
 #include "dbusproxy.h"
+#include "querytrace.h"
+#include "residentmode.h"
+#include "searchprovider.h"
+#include "textcache.h"
 
 DBusProxy::DBusProxy(SystemTray &t, MainWindow &w, QObject *parent):tray(t),widget(w)
 {
-
+    connect(w.indexProgress(), &IndexProgressMonitor::progressChanged,
+            [this](const IndexProgress &p) {
+        emit IndexProgressChanged(p.toVariantMap());
+    });
+    connect(&w, &MainWindow::indexGenerationChanged, &searchService, &SearchService::invalidate);
+    connect(&searchService, &SearchService::batchReady, this, &DBusProxy::SearchResults);
+    connect(&searchService, &SearchService::failed, this, &DBusProxy::SearchFailed);
 }
 
 void DBusProxy::IndexChangeFiles(QStringList paths)
@@ -21,3 +31,42 @@ void DBusProxy::showWindow()
     this->tray.showWindow();
 
 }
+
+QVariantMap DBusProxy::GetIndexQueueStats()
+{
+    return this->widget.indexQueue()->stats();
+}
+
+QVariantMap DBusProxy::GetIndexProgress()
+{
+    return this->widget.indexProgress()->current().toVariantMap();
+}
+
+QVariantMap DBusProxy::GetSummonStats()
+{
+    return ResidentMode::instance()->summonStats();
+}
+
+QVariantMap DBusProxy::GetProviderStats()
+{
+    return ProviderHub::instance()->stats();
+}
+
+QVariantMap DBusProxy::GetTextCacheStats()
+{
+    return TextCache::instance()->stats();
+}
+
+QString DBusProxy::DumpQueryTrace(QString path)
+{
+    return QueryTrace::dump(path);
+}
+
+uint DBusProxy::Search(QString query, int limit)
+{
+    // theconfig 在后台线程里创建，准备好之前不能打开数据库
+    if (!widget.backendReady()) {
+        return searchService.reject("not ready");
+    }
+    return searchService.search(query, limit);
+}
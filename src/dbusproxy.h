@@ -2,6 +2,7 @@
 #define DBUSPROXY_H
 
 #include "everylaunchermonitor_interface.h"
+#include "searchservice.h"
 #include "systemtray.h"
 #include "widget.h"
 #include "config.h"
@@ -30,12 +31,24 @@ public:
 public slots:
     void IndexChangeFiles(QStringList paths);
     void showWindow();
+    QVariantMap GetIndexQueueStats();
+    QVariantMap GetIndexProgress();
+    QVariantMap GetSummonStats();
+    QVariantMap GetProviderStats();
+    QVariantMap GetTextCacheStats();
+    QString DumpQueryTrace(QString path);
+    // 马上返回查询编号，结果分批用 SearchResults 发出，调用前先连接信号
+    uint Search(QString query, int limit);
 
 signals:
+    void IndexProgressChanged(QVariantMap progress);
+    void SearchResults(uint id, QString stage, QVariantList results, bool final);
+    void SearchFailed(uint id, QString error);
 
 private:
     SystemTray &tray;
     MainWindow 	&widget;
+    SearchService searchService;
 
 };
 
@@ -23,20 +23,48 @@ static QMap<QString,int> str2idx({
 //                                { "image/svg+xml",4},
 
                                  });
+static const int paneCount = 5;
+
 DetailedWidget::DetailedWidget(QWidget *parent) :QStackedWidget(parent)
 {
-    insertWidget(0,new DetailedW);
-    insertWidget(1,new Preview);
-    insertWidget(2,new DesktopPreview);
-    insertWidget(3,new PdfPreview(this));
-    insertWidget(4,new imagePreview(this));
+    m_panes.fill(nullptr, paneCount);
+}
+
+QWidget *DetailedWidget::pane(int idx)
+{
+    if (idx < 0 || idx >= paneCount) {
+        idx = 0;
+    }
+    if (m_panes[idx] == nullptr) {
+        QWidget *w = nullptr;
+        switch (idx) {
+        case 1:
+            w = new Preview;
+            break;
+        case 2:
+            w = new DesktopPreview;
+            break;
+        case 3:
+            w = new PdfPreview(this);
+            break;
+        case 4:
+            w = new imagePreview(this);
+            break;
+        default:
+            w = new DetailedW;
+            break;
+        }
+        addWidget(w);
+        m_panes[idx] = w;
+    }
+    return m_panes[idx];
 }
 
 void DetailedWidget::showDocDetail(QModelIndex index, Rcl::Doc doc, HighlightData hl)
 {
     qDebug()<<"item mime:"<<index.data(RecollModel::ModelRoles::Role_MIME_TYPE).toString();
-   auto wid=str2idx[index.data(RecollModel::ModelRoles::Role_MIME_TYPE).toString()];
-   this->setCurrentIndex(wid);
+   auto wid=str2idx.value(index.data(RecollModel::ModelRoles::Role_MIME_TYPE).toString(),0);
+   this->setCurrentWidget(pane(wid));
    auto curr=qobject_cast<DetailedW *>( this->currentWidget());
    curr->setHighlightData(hl);
    curr->setIndex(index);
@@ -3,6 +3,7 @@
 
 #include <QModelIndex>
 #include <QStackedWidget>
+#include <QVector>
 #include <QWidget>
 #include <hldata.h>
 #include <rcldoc.h>
@@ -18,6 +19,10 @@ signals:
 
 public slots:
 private:
+    // 第一次用到时才创建对应的预览控件
+    QWidget *pane(int idx);
+private:
+    QVector<QWidget *> m_panes;
 };
 
 #endif // DETAILEDWIDGET_H
@@ -0,0 +1,269 @@
+#include "docseqranked.h"
+#include "frecency.h"
+#include "querytrace.h"
+
+#include <QHash>
+#include <log.h>
+
+#include <algorithm>
+#include <cmath>
+
+// 用同样的输入打开过一次 score 约为 1.2，0.3 * log1p(1.2) 大约相当于 24 分的相关度，
+// 十次大约 77 分
+static const double frecencyWeight = 0.3;
+
+const std::string DocSeqRanked::groupField = "resultgroup";
+
+QString DocSeqRanked::groupOf(const Rcl::Doc &doc)
+{
+    auto it = doc.meta.find(groupField);
+    return QString::fromStdString(it != doc.meta.end() ? it->second : doc.mimetype);
+}
+
+DocSeqRanked::DocSeqRanked(std::shared_ptr<DocSequence> iseq, const QString &query,
+                           int pageSize)
+    : DocSeqModifier(iseq), m_query(query), m_pageSize(pageSize)
+{
+}
+
+int DocSeqRanked::fetch(int count)
+{
+    int fetched = 0;
+    auto &seq = m_more ? m_more : m_seq;
+    while (fetched < count && !m_exhausted) {
+        Rcl::Doc doc;
+        // 取文档时 DocSequenceDb 会生成摘要，超出结果范围时返回 false
+        if (!seq->getDoc(int(m_docs.size()), doc)) {
+            m_exhausted = true;
+            break;
+        }
+        m_docs.push_back(std::move(doc));
+        fetched++;
+    }
+    return fetched;
+}
+
+void DocSeqRanked::rank()
+{
+    if (m_ranked) {
+        return;
+    }
+    m_ranked = true;
+    // 只重排第一页，后面的页保持原来的顺序
+    {
+        QueryTrace::Span span("fetch");
+        span.setArg("docs", fetch(m_pageSize));
+    }
+    m_firstPage = int(m_docs.size());
+    m_consumed = m_firstPage;
+    QueryTrace::Span span("rank");
+    sortFirstPage();
+    LOGDEB("DocSeqRanked::rank: " << m_order.size() << " docs\n");
+}
+
+void DocSeqRanked::sortFirstPage()
+{
+    struct Entry {
+        int src;
+        QString group;
+        double score;
+    };
+    std::vector<Entry> entries;
+    QHash<QString, double> groupBest;
+    auto store = FrecencyStore::instance();
+    auto addEntry = [&](int src, const Rcl::Doc &doc, const QString &key) {
+        auto boost = store->score(m_query, key);
+        double score = doc.pc / 100.0 + frecencyWeight * std::log1p(boost);
+        auto group = groupOf(doc);
+        entries.push_back({src, group, score});
+        if (!groupBest.contains(group) || groupBest[group] < score) {
+            groupBest[group] = score;
+        }
+    };
+    for (int i = 0; i < m_firstPage; i++) {
+        auto &doc = m_docs[i];
+        auto key = FrecencyStore::docKey(doc.url, doc.ipath);
+        if (!m_externalKeys.contains(key)) {
+            addEntry(i, doc, key);
+        }
+    }
+    for (auto k : m_merged) {
+        auto &doc = m_external[k];
+        addEntry(-k - 1, doc, FrecencyStore::docKey(doc.url, doc.ipath));
+    }
+    std::stable_sort(entries.begin(), entries.end(),
+                     [&groupBest](const Entry &a, const Entry &b) {
+                         if (a.group != b.group) {
+                             auto ga = groupBest[a.group], gb = groupBest[b.group];
+                             return ga != gb ? ga > gb : a.group < b.group;
+                         }
+                         return a.score > b.score;
+                     });
+    m_order.clear();
+    for (int k = 0; k < m_leadingCount; k++) {
+        m_order.push_back(-k - 1);
+    }
+    for (const auto &e : entries) {
+        m_order.push_back(e.src);
+    }
+    // 第一页之后已经显示的部分保持原样
+    for (int i = m_firstPage; i < m_consumed; i++) {
+        const auto &doc = m_docs[i];
+        if (!m_externalKeys.contains(FrecencyStore::docKey(doc.url, doc.ipath))) {
+            m_order.push_back(i);
+        }
+    }
+}
+
+void DocSeqRanked::setLeading(std::vector<Rcl::Doc> docs)
+{
+    m_external.clear();
+    m_externalKeys.clear();
+    m_merged.clear();
+    addExternal(std::move(docs));
+    m_leadingCount = int(m_external.size());
+}
+
+std::vector<int> DocSeqRanked::addExternal(std::vector<Rcl::Doc> docs)
+{
+    // 底层序列里已经显示的文档优先，它们有摘要
+    QSet<QString> shown;
+    for (int i = 0; i < m_consumed; i++) {
+        shown.insert(FrecencyStore::docKey(m_docs[i].url, m_docs[i].ipath));
+    }
+    std::vector<int> added;
+    for (auto &doc : docs) {
+        auto key = FrecencyStore::docKey(doc.url, doc.ipath);
+        if (shown.contains(key) || m_externalKeys.contains(key)) {
+            continue;
+        }
+        m_externalKeys.insert(key);
+        added.push_back(int(m_external.size()));
+        m_external.push_back(std::move(doc));
+    }
+    return added;
+}
+
+void DocSeqRanked::merge(std::vector<Rcl::Doc> docs)
+{
+    rank();
+    auto added = addExternal(std::move(docs));
+    if (added.empty()) {
+        return;
+    }
+    m_merged.insert(m_merged.end(), added.begin(), added.end());
+    sortFirstPage();
+}
+
+std::vector<Rcl::Doc> DocSeqRanked::leadingDocs() const
+{
+    return std::vector<Rcl::Doc>(m_external.begin(), m_external.begin() + m_leadingCount);
+}
+
+std::vector<Rcl::Doc> DocSeqRanked::mergedDocs() const
+{
+    std::vector<Rcl::Doc> out;
+    for (auto k : m_merged) {
+        out.push_back(m_external[k]);
+    }
+    return out;
+}
+
+void DocSeqRanked::append(std::vector<Rcl::Doc> docs)
+{
+    rank();
+    for (auto k : addExternal(std::move(docs))) {
+        m_order.push_back(-k - 1);
+    }
+}
+
+int DocSeqRanked::estimatedTotal() const
+{
+    int visible = int(m_order.size());
+    // 已经取完了就是准确的总数（最多多算几个重复的）
+    if (m_exhausted) {
+        return visible + int(m_docs.size()) - m_consumed;
+    }
+    return std::max(m_estimate, visible);
+}
+
+int DocSeqRanked::prefetch(int count)
+{
+    rank();
+    int pending = int(m_docs.size()) - m_consumed;
+    if (pending < count) {
+        QueryTrace::Span span("fetch more");
+        span.setArg("docs", fetch(count - pending));
+    }
+    return std::min(count, int(m_docs.size()) - m_consumed);
+}
+
+void DocSeqRanked::showMore(int count)
+{
+    count = std::min(count, int(m_docs.size()) - m_consumed);
+    for (int i = m_consumed; i < m_consumed + count; i++) {
+        const auto &doc = m_docs[i];
+        if (!m_externalKeys.contains(FrecencyStore::docKey(doc.url, doc.ipath))) {
+            m_order.push_back(i);
+        }
+    }
+    m_consumed += count;
+}
+
+int DocSeqRanked::getResCnt()
+{
+    // 查询线程里先算 getResCnt，第一页的重排也放在那里做
+    rank();
+    return int(m_order.size());
+}
+
+bool DocSeqRanked::getDoc(int num, Rcl::Doc &doc, std::string *sh)
+{
+    rank();
+    if (sh) {
+        sh->erase();
+    }
+    if (num < 0 || num >= int(m_order.size())) {
+        return false;
+    }
+    auto pos = m_order[num];
+    doc = pos < 0 ? m_external[-pos - 1] : m_docs[pos];
+    return true;
+}
+
+template <typename F> void DocSeqRanked::forEachPending(F f) const
+{
+    for (int i = m_consumed; i < int(m_docs.size()); i++) {
+        const auto &doc = m_docs[i];
+        if (!m_externalKeys.contains(FrecencyStore::docKey(doc.url, doc.ipath))) {
+            f(doc);
+        }
+    }
+}
+
+std::shared_ptr<DocSeqRanked> DocSeqRanked::filtered(const QString &group,
+                                                     std::shared_ptr<DocSequence> more)
+{
+    rank();
+    std::vector<Rcl::Doc> docs;
+    for (auto pos : m_order) {
+        const auto &doc = pos < 0 ? m_external[-pos - 1] : m_docs[pos];
+        if (groupOf(doc) == group) {
+            docs.push_back(doc);
+        }
+    }
+    forEachPending([&](const Rcl::Doc &doc) {
+        if (groupOf(doc) == group) {
+            docs.push_back(doc);
+        }
+    });
+    auto view = std::make_shared<DocSeqRanked>(m_seq, m_query, m_pageSize);
+    // 已有的文档不重新打分，more 里重复的文档会被跳过
+    view->setLeading(std::move(docs));
+    view->m_more = std::move(more);
+    view->m_db = m_db;
+    view->m_ranked = true;
+    view->m_exhausted = !view->m_more;
+    view->sortFirstPage();
+    return view;
+}
@@ -0,0 +1,112 @@
+#ifndef DOCSEQRANKED_H
+#define DOCSEQRANKED_H
+
+#include <QSet>
+#include <QString>
+#include <docseq.h>
+
+#include <memory>
+#include <vector>
+
+namespace Rcl {
+class Db;
+}
+
+/*
+ * 结果重排。取底层结果的第一页，按 Xapian 相关度加上 frecency 分数重新打分，
+ * 然后按 mime 类型分组：组的顺序由组内最高分决定，组内按分数排序。
+ * 代替原来在 Xapian 里按 mtype 排序。
+ *
+ * 不做精确计数：getResCnt() 只返回已经取出的行数，后面的结果在滚动时
+ * 用 prefetch()/showMore() 一页一页追加（保持底层顺序，已显示的行不再移动）。
+ * 总数只用 Xapian 的估计值显示。
+ *
+ * 两阶段查询时，第一阶段（文件名、标题、程序名）的结果用 setLeading 放在最前面，
+ * 底层序列里同一个文档不再重复出现。
+ * 其它来源（SearchProvider）按时返回的结果用 merge 和第一页一起打分分组，
+ * 迟到的结果用 append 接在最后。
+ *
+ * 按分组查看时用 filtered 从已经取出的结果里挑出这一组，不用重新查询；
+ * 只有继续滚动时才从只查这一组的序列里按页取。
+ */
+class DocSeqRanked : public DocSeqModifier
+{
+public:
+    DocSeqRanked(std::shared_ptr<DocSequence> iseq, const QString &query,
+                 int pageSize = 50);
+    ~DocSeqRanked() override = default;
+
+    // SearchProvider 可以在 meta 的这个字段里指定分组，没有时按 mime 类型分组
+    static const std::string groupField;
+    static QString groupOf(const Rcl::Doc &doc);
+
+    bool getDoc(int num, Rcl::Doc &doc, std::string *sh = nullptr) override;
+    int getResCnt() override;
+
+    // 在 getResCnt/getDoc 之前调用
+    void setLeading(std::vector<Rcl::Doc> docs);
+    // 结果显示之前调用，和第一页一起重排
+    void merge(std::vector<Rcl::Doc> docs);
+    // 结果已经显示后调用，不改变已有行的顺序
+    void append(std::vector<Rcl::Doc> docs);
+    // 底层序列（recoll）已经取出的条数，不包括 setLeading 和其它来源的文档
+    int sourceCount() const { return int(m_docs.size()); }
+    // setLeading 设置的文档和 merge 进来的文档，容错重试时交给新的序列
+    std::vector<Rcl::Doc> leadingDocs() const;
+    std::vector<Rcl::Doc> mergedDocs() const;
+    // Xapian 估计的结果总数，未知时为 -1
+    void setEstimate(int estimate) { m_estimate = estimate; }
+    int estimatedTotal() const;
+    bool canFetchMore() const { return !m_exhausted; }
+    // 取出最多 count 条还没显示的结果，返回实际取到的条数
+    int prefetch(int count);
+    // 把 prefetch 取到的 count 条加入显示
+    void showMore(int count);
+
+    // 底层的 Rcl::Query 只保存 Db 的指针，换了数据库（maybeOpenDb）以后
+    // 旧的结果还要能继续翻页，由这里保持数据库不被释放
+    void keepDb(std::shared_ptr<Rcl::Db> db) { m_db = std::move(db); }
+    std::shared_ptr<Rcl::Db> db() const { return m_db; }
+
+    // 只包含 group 这一组的视图，已经取出的文档按当前顺序排在前面。
+    // more 是只查这一组的序列，为空时不再加载更多
+    std::shared_ptr<DocSeqRanked> filtered(const QString &group,
+                                           std::shared_ptr<DocSequence> more);
+
+private:
+    void rank();
+    // 重新排列第一页和 merge 进来的文档
+    void sortFirstPage();
+    // 其它来源的文档中不重复的加入 m_external，返回加入的位置
+    std::vector<int> addExternal(std::vector<Rcl::Doc> docs);
+    // 按底层顺序接着取 count 条到 m_docs
+    int fetch(int count);
+    // 已经取出但还没显示的文档，不包括和 m_external 重复的
+    template <typename F> void forEachPending(F f) const;
+
+private:
+    QString m_query;
+    // 不为空时从这里取后面的页，m_seq 只用来取高亮词等
+    std::shared_ptr<DocSequence> m_more;
+    std::shared_ptr<Rcl::Db> m_db;
+    int m_pageSize;
+    bool m_ranked{false};
+    bool m_exhausted{false};
+    int m_estimate{-1};
+    // 第一页的条数
+    int m_firstPage{0};
+    // m_docs 中已经参与显示的条数（包括和 m_external 重复而跳过的）
+    int m_consumed{0};
+    // 显示位置 -> m_docs 中的位置，负数 -k-1 表示 m_external[k]
+    std::vector<int> m_order;
+    // 按底层顺序取出的文档
+    std::vector<Rcl::Doc> m_docs;
+    // 不是来自底层序列的文档，前 m_leadingCount 个是 setLeading 设置的
+    std::vector<Rcl::Doc> m_external;
+    int m_leadingCount{0};
+    // m_external 中所有文档的 key
+    QSet<QString> m_externalKeys;
+    std::vector<int> m_merged;
+};
+
+#endif // DOCSEQRANKED_H
@@ -0,0 +1,53 @@
+# 不依赖界面的查询引擎：编译、执行、分组、重排，以及其它结果来源。
+# everylauncher.pri 和命令行工具 query/ 都包含这个文件
+QT       += core gui concurrent
+
+LIBS += -lrecoll
+LIBS += -L$$PWD/../lib
+
+QMAKE_RPATHDIR +=/usr/lib/recoll
+CONFIG += c++11 link_pkgconfig
+PKGCONFIG += Qt5Xdg dtkcore
+QMAKE_CXXFLAGS += -std=c++11
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH+=$$PWD \
+                $$PWD/../../recoll1-code/src/query\
+                $$PWD/../../recoll1-code/src/utils\
+                $$PWD/../../recoll1-code/src/rcldb\
+                $$PWD/../../recoll1-code/src/internfile\
+                $$PWD/../../recoll1-code/src/unac\
+                $$PWD/../../recoll1-code/src/common\
+                $$PWD/../../recoll1-code/src/qtgui
+
+SOURCES += \
+    $$PWD/config.cpp \
+    $$PWD/guiutils.cpp \
+    $$PWD/frecency.cpp \
+    $$PWD/docseqranked.cpp \
+    $$PWD/termdict.cpp \
+    $$PWD/fuzzyindex.cpp \
+    $$PWD/querycompiler.cpp \
+    $$PWD/querytrace.cpp \
+    $$PWD/searchprovider.cpp \
+    $$PWD/recentfiles.cpp \
+    $$PWD/appindex.cpp \
+    $$PWD/pathscan.cpp \
+    $$PWD/pathindex.cpp \
+    $$PWD/searchengine.cpp
+
+HEADERS += \
+    $$PWD/config.h \
+    $$PWD/guiutils.h \
+    $$PWD/frecency.h \
+    $$PWD/docseqranked.h \
+    $$PWD/termdict.h \
+    $$PWD/fuzzyindex.h \
+    $$PWD/querycompiler.h \
+    $$PWD/querytrace.h \
+    $$PWD/searchprovider.h \
+    $$PWD/recentfiles.h \
+    $$PWD/appindex.h \
+    $$PWD/pathscan.h \
+    $$PWD/pathindex.h \
+    $$PWD/searchengine.h
@@ -0,0 +1,103 @@
+# 除了 main.cpp 以外的所有代码和依赖，
+# bench/ 下需要完整界面的基准测试也包含这个文件
+include($$PWD/engine.pri)
+
+QT       += dbus x11extras
+
+LIBS += -lzstd
+LIBS += -lX11 -lXext -lQt5Pdf -lQt5PdfWidgets
+
+PKGCONFIG += dtkwidget xcb xcb-util
+
+INCLUDEPATH+=$$PWD/../../qtpdf/include\
+                $$PWD/../../qtpdf/include/QtPdf
+
+SOURCES += \
+    $$PWD/widget.cpp \
+    $$PWD/systemtray.cpp \
+    $$PWD/preferencewindow.cpp \
+    $$PWD/configlistwidget.cpp \
+    $$PWD/indexsche.cpp \
+    $$PWD/reslistwidget.cpp \
+    $$PWD/searchline.cpp \
+    $$PWD/dbusproxy.cpp \
+    $$PWD/everylaunchermonitor_interface.cpp \
+    $$PWD/msortfilterproxymodel.cpp \
+    $$PWD/detailedwidget.cpp \
+    $$PWD/recollmodel.cpp \
+    $$PWD/Detailed/detailedtext.cpp \
+    $$PWD/Detailed/preview_w.cpp \
+    $$PWD/Detailed/preview_load.cpp \
+    $$PWD/Detailed/preview_plaintorich.cpp \
+    $$PWD/Detailed/previewtextedit.cpp \
+    $$PWD/confgui/confgui.cpp \
+    $$PWD/confgui/confguiindex.cpp \
+    $$PWD/Detailed/desktoppreview.cpp \
+    $$PWD/globalshortcut.cpp \
+    $$PWD/Detailed/pdfpreview.cpp \
+    $$PWD/Detailed/imagepreview.cpp \
+    $$PWD/firsttimeinit.cpp \
+    $$PWD/fswatcher.cpp \
+    $$PWD/indexworker.cpp \
+    $$PWD/indexqueue.cpp \
+    $$PWD/indexprogress.cpp \
+    $$PWD/indexscheduler.cpp \
+    $$PWD/startuptrace.cpp \
+    $$PWD/residentmode.cpp \
+    $$PWD/launcher.cpp \
+    $$PWD/searchhistory.cpp \
+    $$PWD/textcache.cpp \
+    $$PWD/restabledelegate.cpp \
+    $$PWD/searchservice.cpp
+
+HEADERS += \
+    $$PWD/widget.h \
+    $$PWD/systemtray.h \
+    $$PWD/preferencewindow.h \
+    $$PWD/configlistwidget.h \
+    $$PWD/indexsche.h \
+    $$PWD/reslistwidget.h \
+    $$PWD/searchline.h \
+    $$PWD/dbusproxy.h \
+    $$PWD/everylaunchermonitor_interface.h \
+    $$PWD/msortfilterproxymodel.h \
+    $$PWD/detailedwidget.h \
+    $$PWD/recollmodel.h \
+    $$PWD/Detailed/detailedtext.h \
+    $$PWD/Detailed/preview_w.h \
+    $$PWD/Detailed/preview_load.h \
+    $$PWD/Detailed/preview_plaintorich.h \
+    $$PWD/Detailed/previewtextedit.h \
+    $$PWD/confgui/confgui.h \
+    $$PWD/confgui/confguiindex.h \
+    $$PWD/Detailed/desktoppreview.h \
+    $$PWD/globalshortcut.h \
+    $$PWD/Detailed/pdfpreview.h \
+    $$PWD/Detailed/imagepreview.h \
+    $$PWD/firsttimeinit.h \
+    $$PWD/fswatcher.h \
+    $$PWD/indexworker.h \
+    $$PWD/indexqueue.h \
+    $$PWD/indexprogress.h \
+    $$PWD/indexscheduler.h \
+    $$PWD/startuptrace.h \
+    $$PWD/residentmode.h \
+    $$PWD/launcher.h \
+    $$PWD/searchhistory.h \
+    $$PWD/textcache.h \
+    $$PWD/restabledelegate.h \
+    $$PWD/searchservice.h
+
+FORMS += \
+        $$PWD/widget.ui
+
+dbus.files = $$PWD/com.gitee.wanywhn.EveryLauncher.xml
+dbus.header_flags += -l DBusProxy -i $$PWD/dbusproxy.h
+dbus.source_flags += -l DBusProxy
+
+dbus_itface.files= $$PWD/com.gitee.wanywhn.EveryLauncher.xml
+dbus_itface.header_flags += -c EveryLauncherInterface
+dbus_itface.source_flags += -c EveryLauncherInterface
+
+DBUS_ADAPTORS += dbus
+DBUS_INTERFACES +=dbus_itface
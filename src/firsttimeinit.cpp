@@ -3,7 +3,6 @@
 #include <QDir>
 #include <QLabel>
 #include <QMessageBox>
-#include <QProcess>
 #include <QStandardPaths>
 #include <QVBoxLayout>
 
@@ -12,7 +11,8 @@
 
 
 
-firstTimeInit::firstTimeInit(QWidget *parent) : DDialog(parent) {
+firstTimeInit::firstTimeInit(QWidget *parent, IndexWorker *worker)
+    : DDialog(parent), m_worker(worker) {
   plusBtn = new DTextButton("添加", this);
   minusBtn = new DTextButton("删除", this);
   startBtn = new DTextButton("立即开始索引", this);
@@ -105,41 +105,23 @@ void firstTimeInit::setTopdirsAndIndex()
     m_conf = nullptr;
     theconfig->updateMainConfig();
 
-    QProcess *p=new QProcess(this);
-    QStringList args;
-    args<<"-c";
-    args<<QString::fromStdString(theconfig->getConfDir());
-
-    args<<"-i";
-    args<<"-Z";
-    args<<model->stringList();
-    connect(p,&QProcess::readyRead,[this,p](){
-        QTextStream ts(p);
-
-        QRegularExpression rxp("docid (\\d+) (?:added|updated) \\[(.*)\\|\\]$");
-        while(!ts.atEnd()){
-            auto l=ts.readLine();
-            auto matches=rxp.match(l);
-            if(!matches.hasMatch()){
-                continue;
-            }
-            QString text="正在处理第"+matches.captured(1)+"个文件:"+matches.captured(2);
-            cp->setLabelText(text);
+    connect(m_worker,&IndexWorker::progress,this,[this](int done,int total,QString fn){
+        QString text="正在处理第"+QString::number(done)+"个文件:"+fn;
+        cp->setLabelText(text);
+        if(total>0){
+            cp->setRange(0,total);
+            cp->setValue(qMin(done,total));
         }
     });
-    connect(p,QOverload<int>::of(&QProcess::finished),[this](){
-        cp->hide();
-        this->accept();
-    });
-    connect(p,&QProcess::errorOccurred,[this](){
+    connect(m_worker,&IndexWorker::indexingFinished,this,[this](bool ok){
         cp->hide();
+        if(ok){
+            this->accept();
+        }
     });
-    p->setProcessChannelMode(QProcess::MergedChannels);
     cp->setRange(0,0);
         cp->show();
-    p->start("recollindex",args);
-
-
-
-
+    // 相当于 recollindex -Z，新加入的目录全部重新处理
+    QMetaObject::invokeMethod(m_worker,"indexAll",Qt::QueuedConnection,
+                              Q_ARG(bool,true));
 }
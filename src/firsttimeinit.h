@@ -7,11 +7,13 @@
 #include <QStringListModel>
 #include <QProgressDialog>
 
+#include "indexworker.h"
+
 class firstTimeInit : public DDialog
 {
     Q_OBJECT
 public:
-    firstTimeInit(QWidget *parent);
+    firstTimeInit(QWidget *parent, IndexWorker *worker);
 
 private:
     void init_ui();
@@ -25,6 +27,7 @@ private:
     QStringListModel *model;
   QStringList lists;
      QProgressDialog *cp;
+    IndexWorker *m_worker;
 
 };
 
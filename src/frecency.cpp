@@ -0,0 +1,200 @@
+#include "frecency.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QStandardPaths>
+
+#include <cmath>
+#include <cstring>
+
+static const quint32 magic = 0x46524543; // "FREC"
+static const quint32 version = 1;
+// 16384 * 24 字节，大约 400 KB
+static const quint32 slotCount = 16384;
+// 线性探测的最大长度，超出后替换这一段里分数最低的
+static const int probeLimit = 32;
+// 半衰期一周
+static const double halfLifeSecs = 7 * 24 * 3600.0;
+// 记录的最长前缀，再长的查询只记完整的
+static const int maxPrefixLen = 8;
+// 不区分查询时的全局记录
+static const quint64 anyPrefix = 0;
+
+static quint64 fnv1a(const QByteArray &data)
+{
+    quint64 h = 1469598103934665603ULL;
+    for (auto c : data) {
+        h ^= quint8(c);
+        h *= 1099511628211ULL;
+    }
+    // 0 保留给空槽
+    return h == 0 ? 1 : h;
+}
+
+static quint32 nowSecs()
+{
+    return quint32(QDateTime::currentSecsSinceEpoch());
+}
+
+FrecencyStore *FrecencyStore::instance()
+{
+    static auto instance = new FrecencyStore;
+    return instance;
+}
+
+FrecencyStore::FrecencyStore()
+{
+    auto dir = QDir(QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation));
+    if (!open(dir.absoluteFilePath("frecency.db"))) {
+        qWarning() << "FrecencyStore: cannot open" << m_file.fileName();
+    }
+}
+
+FrecencyStore::~FrecencyStore()
+{
+    if (m_header != nullptr) {
+        m_file.unmap(reinterpret_cast<uchar *>(m_header));
+    }
+}
+
+bool FrecencyStore::open(const QString &path)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QFile::ReadWrite)) {
+        return false;
+    }
+    qint64 size = sizeof(Header) + qint64(sizeof(Slot)) * slotCount;
+    bool fresh = m_file.size() != size;
+    if (fresh && !m_file.resize(size)) {
+        return false;
+    }
+    auto base = m_file.map(0, size);
+    if (base == nullptr) {
+        return false;
+    }
+    m_header = reinterpret_cast<Header *>(base);
+    m_slots = reinterpret_cast<Slot *>(base + sizeof(Header));
+    if (fresh || m_header->magic != magic || m_header->version != version ||
+        m_header->slots != slotCount) {
+        memset(base, 0, size);
+        m_header->magic = magic;
+        m_header->version = version;
+        m_header->slots = slotCount;
+    }
+    return true;
+}
+
+QString FrecencyStore::normalize(const QString &query)
+{
+    return query.simplified().toLower();
+}
+
+QString FrecencyStore::docKey(const std::string &url, const std::string &ipath)
+{
+    auto key = QString::fromStdString(url);
+    if (!ipath.empty()) {
+        key += "|" + QString::fromStdString(ipath);
+    }
+    return key;
+}
+
+double FrecencyStore::decayed(const Slot &slot, quint32 now)
+{
+    if (slot.doc == 0) {
+        return 0;
+    }
+    double age = now > slot.stamp ? now - slot.stamp : 0;
+    return slot.value * std::exp2(-age / halfLifeSecs);
+}
+
+const FrecencyStore::Slot *FrecencyStore::find(quint64 prefix, quint64 doc) const
+{
+    auto start = (prefix * 31 + doc) % slotCount;
+    for (int i = 0; i < probeLimit; i++) {
+        auto &slot = m_slots[(start + i) % slotCount];
+        if (slot.doc == 0) {
+            return nullptr;
+        }
+        if (slot.prefix == prefix && slot.doc == doc) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+void FrecencyStore::bump(quint64 prefix, quint64 doc, quint32 now)
+{
+    auto start = (prefix * 31 + doc) % slotCount;
+    Slot *target = nullptr;
+    Slot *weakest = nullptr;
+    double weakestScore = 0;
+    for (int i = 0; i < probeLimit; i++) {
+        auto &slot = m_slots[(start + i) % slotCount];
+        if (slot.doc == 0 || (slot.prefix == prefix && slot.doc == doc)) {
+            target = &slot;
+            break;
+        }
+        auto s = decayed(slot, now);
+        if (weakest == nullptr || s < weakestScore) {
+            weakest = &slot;
+            weakestScore = s;
+        }
+    }
+    if (target == nullptr) {
+        // 探测范围内都满了，替换衰减得最厉害的那条，占用的数目不变
+        target = weakest;
+        target->doc = 0;
+    } else if (target->doc == 0) {
+        m_header->used++;
+    }
+    if (target->doc == 0) {
+        target->prefix = prefix;
+        target->doc = doc;
+        target->value = 0;
+    }
+    target->value = float(decayed(*target, now) + 1.0);
+    target->stamp = now;
+}
+
+void FrecencyStore::record(const QString &query, const QString &docKey)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_slots == nullptr || docKey.isEmpty()) {
+        return;
+    }
+    auto doc = fnv1a(docKey.toUtf8());
+    auto q = normalize(query);
+    auto now = nowSecs();
+    // 每个前缀都记一次，之后只输入一两个字就能排到前面
+    for (int len = 1; len <= qMin(q.size(), maxPrefixLen); len++) {
+        bump(fnv1a(q.left(len).toUtf8()), doc, now);
+    }
+    if (q.size() > maxPrefixLen) {
+        bump(fnv1a(q.toUtf8()), doc, now);
+    }
+    bump(anyPrefix, doc, now);
+}
+
+double FrecencyStore::score(const QString &query, const QString &docKey) const
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_slots == nullptr) {
+        return 0;
+    }
+    auto doc = fnv1a(docKey.toUtf8());
+    auto q = normalize(query);
+    auto now = nowSecs();
+    double s = 0;
+    auto key = q.size() > maxPrefixLen ? q : q.left(maxPrefixLen);
+    if (!key.isEmpty()) {
+        if (auto slot = find(fnv1a(key.toUtf8()), doc)) {
+            s = decayed(*slot, now);
+        }
+    }
+    // 和这次查询无关的使用次数只算一小部分
+    if (auto slot = find(anyPrefix, doc)) {
+        s += 0.2 * decayed(*slot, now);
+    }
+    return s;
+}
@@ -0,0 +1,55 @@
+#ifndef FRECENCY_H
+#define FRECENCY_H
+
+#include <QFile>
+#include <QMutex>
+#include <QString>
+
+/*
+ * 记录用户通过启动器打开过什么：(查询前缀, 文档, 时间)。
+ * 保存在一个 mmap 的定长哈希表文件里，分数随时间指数衰减，
+ * 用来在结果排序时给常用的条目加分。
+ */
+class FrecencyStore
+{
+public:
+    static FrecencyStore *instance();
+    ~FrecencyStore();
+
+    // 用户用 query 搜到并打开了 docKey
+    void record(const QString &query, const QString &docKey);
+    // query 下 docKey 当前的分数，没有记录时为 0
+    double score(const QString &query, const QString &docKey) const;
+
+    static QString docKey(const std::string &url, const std::string &ipath);
+    static QString normalize(const QString &query);
+
+private:
+    struct Slot {
+        quint64 prefix;
+        quint64 doc;
+        // 分数在 stamp 时刻的值
+        float value;
+        quint32 stamp;
+    };
+    struct Header {
+        quint32 magic;
+        quint32 version;
+        quint32 slots;
+        quint32 used;
+    };
+
+    FrecencyStore();
+    bool open(const QString &path);
+    void bump(quint64 prefix, quint64 doc, quint32 now);
+    const Slot *find(quint64 prefix, quint64 doc) const;
+    static double decayed(const Slot &slot, quint32 now);
+
+private:
+    QFile m_file;
+    mutable QMutex m_mutex;
+    Header *m_header{nullptr};
+    Slot *m_slots{nullptr};
+};
+
+#endif // FRECENCY_H
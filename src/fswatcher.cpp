@@ -0,0 +1,309 @@
+#include "fswatcher.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fnmatch.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <rclconfig.h>
+
+// 最后一次事件后等待的时间
+static const int quietMs = 150;
+// 从第一次事件开始最多等待的时间
+static const int maxLatencyMs = 700;
+
+static const uint32_t watchMask =
+        IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+        IN_DELETE_SELF | IN_MOVE_SELF | IN_ATTRIB | IN_ONLYDIR | IN_DONT_FOLLOW;
+
+FsWatcher::FsWatcher(RclConfig *config, QObject *parent)
+    : QObject(parent), m_config(config)
+{
+    m_quietTimer = new QTimer(this);
+    m_quietTimer->setSingleShot(true);
+    m_quietTimer->setInterval(quietMs);
+    m_maxLatencyTimer = new QTimer(this);
+    m_maxLatencyTimer->setSingleShot(true);
+    m_maxLatencyTimer->setInterval(maxLatencyMs);
+    connect(m_quietTimer, &QTimer::timeout, this, &FsWatcher::flush);
+    connect(m_maxLatencyTimer, &QTimer::timeout, this, &FsWatcher::flush);
+}
+
+FsWatcher::~FsWatcher()
+{
+    stop();
+}
+
+bool FsWatcher::start()
+{
+    if (m_fd >= 0) {
+        return true;
+    }
+    if (m_config == nullptr) {
+        return false;
+    }
+    // fanotify 需要 CAP_SYS_ADMIN，普通会话进程拿不到，只用 inotify
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        qWarning() << "inotify_init1 failed:" << strerror(errno);
+        return false;
+    }
+
+    m_config->setKeyDir("");
+    m_skippedNames = m_config->getSkippedNames();
+    m_skippedPaths = m_config->getSkippedPaths();
+
+    m_topdirs.clear();
+    for (const auto &dir : m_config->getTopdirs()) {
+        m_topdirs << QDir::cleanPath(QString::fromStdString(dir));
+    }
+    for (const auto &dir : m_topdirs) {
+        addWatchRecursive(dir);
+    }
+
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &FsWatcher::readEvents);
+    qDebug() << "FsWatcher: watching" << m_wdToPath.size() << "directories";
+    return true;
+}
+
+void FsWatcher::stop()
+{
+    if (m_fd < 0) {
+        return;
+    }
+    flush();
+    delete m_notifier;
+    m_notifier = nullptr;
+    ::close(m_fd);
+    m_fd = -1;
+    m_wdToPath.clear();
+    m_pathToWd.clear();
+    m_movedDirs.clear();
+    m_renamedWds.clear();
+}
+
+bool FsWatcher::isSkipped(const QString &path) const
+{
+    auto name = QFileInfo(path).fileName().toStdString();
+    for (const auto &pattern : m_skippedNames) {
+        if (fnmatch(pattern.c_str(), name.c_str(), 0) == 0) {
+            return true;
+        }
+    }
+    auto spath = path.toStdString();
+    for (const auto &pattern : m_skippedPaths) {
+        if (fnmatch(pattern.c_str(), spath.c_str(), FNM_PATHNAME) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FsWatcher::addWatchRecursive(const QString &dir)
+{
+    if (m_pathToWd.contains(dir) || isSkipped(dir)) {
+        return;
+    }
+    int wd = inotify_add_watch(m_fd, dir.toLocal8Bit().constData(), watchMask);
+    if (wd < 0) {
+        if (errno == ENOSPC && !m_watchLimitWarned) {
+            m_watchLimitWarned = true;
+            qWarning() << "FsWatcher: inotify watch limit reached, "
+                          "raise fs.inotify.max_user_watches";
+        }
+        return;
+    }
+    // 同一个目录换了路径时 inotify 返回原来的 wd
+    auto old = m_wdToPath.value(wd);
+    if (!old.isEmpty()) {
+        m_pathToWd.remove(old);
+    }
+    m_wdToPath.insert(wd, dir);
+    m_pathToWd.insert(dir, wd);
+
+    QDirIterator it(dir, QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden |
+                    QDir::NoSymLinks);
+    while (it.hasNext()) {
+        addWatchRecursive(it.next());
+    }
+}
+
+void FsWatcher::removeWatch(int wd)
+{
+    auto path = m_wdToPath.take(wd);
+    if (m_pathToWd.value(path, -1) == wd) {
+        m_pathToWd.remove(path);
+    }
+    m_renamedWds.remove(wd);
+}
+
+static bool isUnder(const QString &path, const QString &dir)
+{
+    return path == dir || (path.startsWith(dir) && path[dir.size()] == '/');
+}
+
+void FsWatcher::remapWatches(const QString &from, const QString &to)
+{
+    QList<QPair<QString, int>> moved;
+    for (auto it = m_pathToWd.begin(); it != m_pathToWd.end();) {
+        if (isUnder(it.key(), from)) {
+            moved.append({it.key(), it.value()});
+            it = m_pathToWd.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (const auto &entry : moved) {
+        auto path = to + entry.first.mid(from.size());
+        m_wdToPath.insert(entry.second, path);
+        m_pathToWd.insert(path, entry.second);
+    }
+}
+
+void FsWatcher::dropWatches(const QString &dir)
+{
+    for (auto it = m_pathToWd.begin(); it != m_pathToWd.end();) {
+        if (isUnder(it.key(), dir)) {
+            // 随后的 IN_IGNORED 找不到路径，直接忽略
+            inotify_rm_watch(m_fd, it.value());
+            m_wdToPath.remove(it.value());
+            m_renamedWds.remove(it.value());
+            it = m_pathToWd.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void FsWatcher::readEvents()
+{
+    alignas(struct inotify_event) char buf[16 * (sizeof(struct inotify_event) + NAME_MAX + 1)];
+    for (;;) {
+        auto len = ::read(m_fd, buf, sizeof(buf));
+        if (len <= 0) {
+            break;
+        }
+        for (char *p = buf; p < buf + len;) {
+            auto ev = reinterpret_cast<struct inotify_event *>(p);
+            p += sizeof(struct inotify_event) + ev->len;
+
+            if (ev->mask & IN_Q_OVERFLOW) {
+                qWarning() << "FsWatcher: event queue overflow, rescanning";
+                emit rescanNeeded();
+                continue;
+            }
+            if (ev->mask & IN_IGNORED) {
+                removeWatch(ev->wd);
+                continue;
+            }
+            auto dir = m_wdToPath.value(ev->wd);
+            if (dir.isEmpty()) {
+                continue;
+            }
+            if (ev->mask & IN_MOVE_SELF) {
+                // 在监控范围内改名的目录已经在 IN_MOVED_TO 里处理了，
+                // 否则是被移出了监控范围，旧的 watch 会继续报告新位置的变化
+                if (!m_renamedWds.remove(ev->wd)) {
+                    queueDeleted(dir);
+                    dropWatches(dir);
+                }
+                continue;
+            }
+            if (ev->mask & IN_DELETE_SELF) {
+                queueDeleted(dir);
+                continue;
+            }
+            if (ev->len == 0) {
+                continue;
+            }
+            auto path = dir + '/' + QString::fromLocal8Bit(ev->name);
+            bool isDir = ev->mask & IN_ISDIR;
+            if (isDir && (ev->mask & IN_MOVED_FROM)) {
+                // 改成被忽略的名字也要删掉原来的路径
+                m_movedDirs.insert(ev->cookie, path);
+                queueDeleted(path);
+                continue;
+            }
+            if (isSkipped(path)) {
+                continue;
+            }
+            if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                queueDeleted(path);
+            } else if (isDir) {
+                if (ev->mask & IN_MOVED_TO) {
+                    auto from = m_movedDirs.take(ev->cookie);
+                    if (!from.isEmpty() && m_pathToWd.contains(from)) {
+                        m_renamedWds.insert(m_pathToWd.value(from));
+                        remapWatches(from, path);
+                    }
+                }
+                if (ev->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    // 新目录里可能已经有文件了（mv 进来或者 mkdir -p 之后立即写入）
+                    addWatchRecursive(path);
+                    queueDirContents(path);
+                }
+            } else if (ev->mask & (IN_CLOSE_WRITE | IN_MOVED_TO | IN_ATTRIB)) {
+                queueChanged(path);
+            } else if ((ev->mask & IN_CREATE) && QFileInfo(path).isSymLink()) {
+                // 符号链接不会有 close_write
+                queueChanged(path);
+            }
+        }
+    }
+    if (!m_changed.isEmpty() || !m_deleted.isEmpty()) {
+        m_quietTimer->start();
+        if (!m_maxLatencyTimer->isActive()) {
+            m_maxLatencyTimer->start();
+        }
+    }
+}
+
+void FsWatcher::queueDirContents(const QString &dir)
+{
+    QDirIterator it(dir, QDir::Files | QDir::Hidden | QDir::System,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        auto path = it.next();
+        if (!isSkipped(path)) {
+            queueChanged(path);
+        }
+    }
+}
+
+void FsWatcher::queueChanged(const QString &path)
+{
+    m_deleted.remove(path);
+    m_changed.insert(path);
+}
+
+void FsWatcher::queueDeleted(const QString &path)
+{
+    m_changed.remove(path);
+    m_deleted.insert(path);
+}
+
+void FsWatcher::flush()
+{
+    m_quietTimer->stop();
+    m_maxLatencyTimer->stop();
+    // 成对的 IN_MOVED_FROM / IN_MOVED_TO 总是一起到达，剩下的是移出去的目录
+    m_movedDirs.clear();
+    if (!m_deleted.isEmpty()) {
+        auto deleted = m_deleted.toList();
+        m_deleted.clear();
+        emit filesDeleted(deleted);
+    }
+    if (!m_changed.isEmpty()) {
+        auto changed = m_changed.toList();
+        m_changed.clear();
+        emit filesChanged(changed);
+    }
+}
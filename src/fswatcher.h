@@ -0,0 +1,77 @@
+#ifndef FSWATCHER_H
+#define FSWATCHER_H
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QSocketNotifier>
+#include <QStringList>
+#include <QTimer>
+
+#include <string>
+#include <vector>
+
+class RclConfig;
+
+/*
+ * 用 inotify 监控 topdirs 下的文件变化，合并短时间内的突发事件后
+ * 以批量的形式发出，供索引器使用。
+ * skippedNames / skippedPaths 中匹配的名字在这里就被丢弃。
+ */
+class FsWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FsWatcher(RclConfig *config, QObject *parent = nullptr);
+    ~FsWatcher() override;
+
+    bool start();
+    void stop();
+    bool isActive() const { return m_fd >= 0; }
+
+signals:
+    void filesChanged(QStringList paths);
+    void filesDeleted(QStringList paths);
+    // inotify 队列溢出，丢失了事件，需要重新扫描整个目录
+    void rescanNeeded();
+
+private slots:
+    void readEvents();
+    void flush();
+
+private:
+    void addWatchRecursive(const QString &dir);
+    void removeWatch(int wd);
+    // 目录在监控范围内改名：wd 不变，把 from 下所有目录的路径换成 to
+    void remapWatches(const QString &from, const QString &to);
+    // 目录被移出监控范围：去掉它和子目录的 watch
+    void dropWatches(const QString &dir);
+    bool isSkipped(const QString &path) const;
+    void queueDirContents(const QString &dir);
+    void queueChanged(const QString &path);
+    void queueDeleted(const QString &path);
+
+private:
+    RclConfig *m_config;
+    int m_fd{-1};
+    QSocketNotifier *m_notifier{nullptr};
+    QHash<int, QString> m_wdToPath;
+    QHash<QString, int> m_pathToWd;
+    QStringList m_topdirs;
+    // IN_MOVED_FROM 的 cookie -> 移走的目录，等对应的 IN_MOVED_TO
+    QHash<quint32, QString> m_movedDirs;
+    // 已经按改名处理过的目录，忽略随后的 IN_MOVE_SELF
+    QSet<int> m_renamedWds;
+    std::vector<std::string> m_skippedNames;
+    std::vector<std::string> m_skippedPaths;
+
+    QSet<QString> m_changed;
+    QSet<QString> m_deleted;
+    // 静默一段时间后发出
+    QTimer *m_quietTimer;
+    // 持续有事件时的最长等待时间，保证一秒内能搜索到
+    QTimer *m_maxLatencyTimer;
+    bool m_watchLimitWarned{false};
+};
+
+#endif // FSWATCHER_H
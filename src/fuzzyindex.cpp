@@ -0,0 +1,213 @@
+#include "fuzzyindex.h"
+#include "termdict.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+#include <unacpp.h>
+
+static const int maxEditDistance = 2;
+// 只对前面这么多个字符生成变体
+static const int prefixLength = 7;
+// 收录的词数上限，大约占 10 MB
+static const int maxTerms = 50000;
+// 太短的词容错没有意义
+static const int minWordLength = 3;
+
+static quint32 hashOf(const QString &s)
+{
+    return qHash(s);
+}
+
+FuzzyIndex *FuzzyIndex::instance()
+{
+    static auto instance = new FuzzyIndex;
+    return instance;
+}
+
+int FuzzyIndex::maxDistanceFor(const QString &word)
+{
+    return word.size() <= 4 ? 1 : maxEditDistance;
+}
+
+int FuzzyIndex::distance(const QString &a, const QString &b, int limit)
+{
+    int n = a.size(), m = b.size();
+    if (qAbs(n - m) > limit) {
+        return limit + 1;
+    }
+    // 只保留三行
+    std::vector<int> prev2(m + 1), prev(m + 1), cur(m + 1);
+    for (int j = 0; j <= m; j++) {
+        prev[j] = j;
+    }
+    for (int i = 1; i <= n; i++) {
+        cur[0] = i;
+        int rowMin = cur[0];
+        for (int j = 1; j <= m; j++) {
+            int cost = a[i - 1] == b[j - 1] ? 0 : 1;
+            cur[j] = std::min({prev[j] + 1, cur[j - 1] + 1, prev[j - 1] + cost});
+            if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1]) {
+                cur[j] = std::min(cur[j], prev2[j - 2] + 1);
+            }
+            rowMin = std::min(rowMin, cur[j]);
+        }
+        if (rowMin > limit) {
+            return limit + 1;
+        }
+        std::swap(prev2, prev);
+        std::swap(prev, cur);
+    }
+    return prev[m];
+}
+
+void FuzzyIndex::addDeletes(const QString &word, int dist, std::vector<QString> &out)
+{
+    QSet<QString> seen;
+    QStringList level;
+    level << word.left(prefixLength);
+    out.push_back(level.first());
+    for (int d = 0; d < dist; d++) {
+        QStringList next;
+        for (const auto &w : level) {
+            if (w.size() <= 1) {
+                continue;
+            }
+            for (int i = 0; i < w.size(); i++) {
+                auto del = QString(w).remove(i, 1);
+                if (!seen.contains(del)) {
+                    seen.insert(del);
+                    next << del;
+                    out.push_back(del);
+                }
+            }
+        }
+        level = next;
+    }
+}
+
+std::shared_ptr<FuzzyIndex::Table> FuzzyIndex::build(std::vector<QString> terms,
+                                                     std::vector<quint32> freqs)
+{
+    auto table = std::make_shared<Table>();
+    table->terms = std::move(terms);
+    table->freqs = std::move(freqs);
+    std::vector<QString> dels;
+    for (quint32 i = 0; i < table->terms.size(); i++) {
+        dels.clear();
+        addDeletes(table->terms[i], maxEditDistance, dels);
+        for (const auto &d : dels) {
+            table->deletes.emplace_back(hashOf(d), i);
+        }
+    }
+    std::sort(table->deletes.begin(), table->deletes.end());
+    return table;
+}
+
+void FuzzyIndex::rebuild()
+{
+    auto dict = TermDict::instance();
+    if (!dict->isOpen()) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_building) {
+            return;
+        }
+        m_building = true;
+    }
+    // 在界面线程里把词复制出来，词典之后可能被重新映射
+    std::vector<std::pair<quint32, int>> byFreq;
+    for (int i = 0; i < dict->size(); i++) {
+        if (dict->termAt(i).size() >= minWordLength) {
+            byFreq.emplace_back(dict->freqAt(i), i);
+        }
+    }
+    auto keep = std::min<size_t>(byFreq.size(), maxTerms);
+    std::partial_sort(byFreq.begin(), byFreq.begin() + keep, byFreq.end(),
+                      [](const std::pair<quint32, int> &a, const std::pair<quint32, int> &b) {
+                          return a.first > b.first;
+                      });
+    std::vector<QString> terms;
+    std::vector<quint32> freqs;
+    for (size_t i = 0; i < keep; i++) {
+        terms.push_back(QString::fromUtf8(dict->termAt(byFreq[i].second)));
+        freqs.push_back(byFreq[i].first);
+    }
+    QtConcurrent::run([this, terms, freqs]() {
+        QElapsedTimer timer;
+        timer.start();
+        auto table = build(terms, freqs);
+        qDebug() << "FuzzyIndex:" << table->terms.size() << "terms,"
+                 << table->deletes.size() << "deletes in" << timer.elapsed() << "ms";
+        QMutexLocker locker(&m_mutex);
+        m_table = table;
+        m_building = false;
+    });
+}
+
+bool FuzzyIndex::isReady() const
+{
+    return table() != nullptr;
+}
+
+std::shared_ptr<const FuzzyIndex::Table> FuzzyIndex::table() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_table;
+}
+
+QVector<FuzzyIndex::Suggestion> FuzzyIndex::suggest(const QString &input, int max) const
+{
+    QVector<Suggestion> out;
+    auto t = table();
+    if (!t) {
+        return out;
+    }
+    std::string folded;
+    if (!unacmaybefold(input.toStdString(), folded, "UTF-8", UNACOP_UNACFOLD)) {
+        folded = input.toLower().toStdString();
+    }
+    auto word = QString::fromStdString(folded);
+    if (word.size() < minWordLength) {
+        return out;
+    }
+    int limit = maxDistanceFor(word);
+    std::vector<QString> dels;
+    addDeletes(word, limit, dels);
+    QSet<quint32> checked;
+    for (const auto &d : dels) {
+        auto h = hashOf(d);
+        auto range = std::equal_range(t->deletes.begin(), t->deletes.end(),
+                                      std::make_pair(h, quint32(0)),
+                                      [](const std::pair<quint32, quint32> &a,
+                                         const std::pair<quint32, quint32> &b) {
+                                          return a.first < b.first;
+                                      });
+        for (auto it = range.first; it != range.second; ++it) {
+            auto idx = it->second;
+            if (checked.contains(idx)) {
+                continue;
+            }
+            checked.insert(idx);
+            const auto &term = t->terms[idx];
+            // 哈希冲突和只比较前缀带来的误报在这里排除
+            int dist = distance(word, term, limit);
+            if (dist <= limit && dist > 0) {
+                out.append({term, dist, t->freqs[idx]});
+            }
+        }
+    }
+    std::sort(out.begin(), out.end(), [](const Suggestion &a, const Suggestion &b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.freq > b.freq;
+    });
+    if (out.size() > max) {
+        out.resize(max);
+    }
+    return out;
+}
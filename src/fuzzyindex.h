@@ -0,0 +1,61 @@
+#ifndef FUZZYINDEX_H
+#define FUZZYINDEX_H
+
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <memory>
+#include <vector>
+
+/*
+ * 拼写容错。用 SymSpell 的方法：对词典中的每个词预先生成删除 1~2 个字符后的变体，
+ * 查询时只对输入词生成同样的变体去查表，再用 Damerau-Levenshtein 距离确认，
+ * 不需要扫描整个词表。
+ * 只收录文档数最多的一部分词，变体只对词的前几个字符生成，控制内存。
+ */
+class FuzzyIndex
+{
+public:
+    struct Suggestion {
+        QString term;
+        int distance;
+        quint32 freq;
+    };
+
+    static FuzzyIndex *instance();
+
+    // 词典重新打开后调用，在后台线程重建
+    void rebuild();
+    bool isReady() const;
+
+    // 和 word 编辑距离在范围内的词，按距离、文档数排序
+    QVector<Suggestion> suggest(const QString &word, int max) const;
+
+    // 允许的最大距离：短词只允许 1
+    static int maxDistanceFor(const QString &word);
+    // 相邻交换算作一次编辑，超过 limit 时提前返回 limit + 1
+    static int distance(const QString &a, const QString &b, int limit);
+
+private:
+    struct Table {
+        std::vector<QString> terms;
+        std::vector<quint32> freqs;
+        // (变体哈希, 词序号)，按哈希排序
+        std::vector<std::pair<quint32, quint32>> deletes;
+    };
+
+    FuzzyIndex() = default;
+    static std::shared_ptr<Table> build(std::vector<QString> terms,
+                                        std::vector<quint32> freqs);
+    static void addDeletes(const QString &word, int dist, std::vector<QString> &out);
+    std::shared_ptr<const Table> table() const;
+
+private:
+    mutable QMutex m_mutex;
+    std::shared_ptr<const Table> m_table;
+    bool m_building{false};
+};
+
+#endif // FUZZYINDEX_H
@@ -0,0 +1,206 @@
+#include "globalshortcut.h"
+
+#include <QApplication>
+#include <QDebug>
+#include <QSettings>
+#include <QX11Info>
+
+#include <X11/Xlib.h>
+#include <X11/keysym.h>
+#include <xcb/xcb.h>
+
+static const char *keyShortcut = "hotkey/showWindow";
+// 原来 XRecord 实现里固定的 Super+Space
+static const char *defaultShortcut = "Meta+Space";
+
+// NumLock 和 CapsLock 的状态不影响快捷键
+static const quint16 ignoredMasks[] = {
+    0,
+    XCB_MOD_MASK_LOCK,
+    XCB_MOD_MASK_2,
+    XCB_MOD_MASK_LOCK | XCB_MOD_MASK_2,
+};
+
+static quint16 toX11Modifiers(Qt::KeyboardModifiers mods)
+{
+    quint16 out = 0;
+    if (mods & Qt::ShiftModifier) {
+        out |= XCB_MOD_MASK_SHIFT;
+    }
+    if (mods & Qt::ControlModifier) {
+        out |= XCB_MOD_MASK_CONTROL;
+    }
+    if (mods & Qt::AltModifier) {
+        out |= XCB_MOD_MASK_1;
+    }
+    if (mods & Qt::MetaModifier) {
+        out |= XCB_MOD_MASK_4;
+    }
+    return out;
+}
+
+static KeySym toKeySym(int key)
+{
+    switch (key) {
+    case Qt::Key_Space:
+        return XK_space;
+    case Qt::Key_Return:
+        return XK_Return;
+    case Qt::Key_Enter:
+        return XK_KP_Enter;
+    case Qt::Key_Tab:
+        return XK_Tab;
+    case Qt::Key_Escape:
+        return XK_Escape;
+    case Qt::Key_Backspace:
+        return XK_BackSpace;
+    case Qt::Key_Insert:
+        return XK_Insert;
+    case Qt::Key_Delete:
+        return XK_Delete;
+    case Qt::Key_Home:
+        return XK_Home;
+    case Qt::Key_End:
+        return XK_End;
+    case Qt::Key_PageUp:
+        return XK_Prior;
+    case Qt::Key_PageDown:
+        return XK_Next;
+    case Qt::Key_Print:
+        return XK_Print;
+    default:
+        break;
+    }
+    if (key >= Qt::Key_F1 && key <= Qt::Key_F35) {
+        return XK_F1 + (key - Qt::Key_F1);
+    }
+    // 字母、数字和符号直接用名字查
+    auto name = QKeySequence(key).toString();
+    return XStringToKeysym(name.toLatin1().constData());
+}
+
+GlobalShortcut *GlobalShortcut::instance()
+{
+    static auto instance = new GlobalShortcut(qApp);
+    return instance;
+}
+
+GlobalShortcut::GlobalShortcut(QObject *parent) : QObject(parent)
+{
+    qApp->installNativeEventFilter(this);
+}
+
+GlobalShortcut::~GlobalShortcut()
+{
+    ungrab();
+}
+
+bool GlobalShortcut::reload()
+{
+    QSettings s;
+    auto seq = QKeySequence(s.value(keyShortcut, defaultShortcut).toString());
+    return grab(seq);
+}
+
+bool GlobalShortcut::setShortcut(const QKeySequence &sequence)
+{
+    if (sequence == m_sequence && m_grabbed) {
+        return true;
+    }
+    if (sequence.isEmpty()) {
+        ungrab();
+        m_sequence = sequence;
+        QSettings().setValue(keyShortcut, QString());
+        return true;
+    }
+    auto old = m_sequence;
+    if (!grab(sequence)) {
+        // 新的绑定不可用时恢复原来的
+        if (!old.isEmpty()) {
+            grab(old);
+        }
+        return false;
+    }
+    QSettings().setValue(keyShortcut, sequence.toString());
+    return true;
+}
+
+bool GlobalShortcut::grab(const QKeySequence &sequence)
+{
+    ungrab();
+    m_sequence = sequence;
+    if (sequence.isEmpty() || !QX11Info::isPlatformX11()) {
+        return false;
+    }
+    int combined = sequence[0];
+    auto key = combined & ~Qt::KeyboardModifierMask;
+    auto sym = toKeySym(key);
+    if (sym == NoSymbol) {
+        qWarning() << "GlobalShortcut: unsupported key" << sequence.toString();
+        return false;
+    }
+    m_keycode = XKeysymToKeycode(QX11Info::display(), sym);
+    m_modifiers = toX11Modifiers(Qt::KeyboardModifiers(combined & Qt::KeyboardModifierMask));
+    if (m_keycode == 0) {
+        qWarning() << "GlobalShortcut: no keycode for" << sequence.toString();
+        return false;
+    }
+
+    auto conn = QX11Info::connection();
+    QVector<xcb_void_cookie_t> cookies;
+    for (auto mask : ignoredMasks) {
+        cookies << xcb_grab_key_checked(conn, 1, QX11Info::appRootWindow(),
+                                        m_modifiers | mask, m_keycode,
+                                        XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+    }
+    bool ok = true;
+    for (auto cookie : cookies) {
+        auto error = xcb_request_check(conn, cookie);
+        if (error != nullptr) {
+            ok = false;
+            free(error);
+        }
+    }
+    if (!ok) {
+        // 多半是被窗口管理器或其它程序占用了
+        qWarning() << "GlobalShortcut: failed to grab" << sequence.toString();
+        m_grabbed = true;
+        ungrab();
+        return false;
+    }
+    m_grabbed = true;
+    return true;
+}
+
+void GlobalShortcut::ungrab()
+{
+    if (!m_grabbed) {
+        return;
+    }
+    auto conn = QX11Info::connection();
+    for (auto mask : ignoredMasks) {
+        xcb_ungrab_key(conn, m_keycode, QX11Info::appRootWindow(), m_modifiers | mask);
+    }
+    xcb_flush(conn);
+    m_grabbed = false;
+}
+
+bool GlobalShortcut::nativeEventFilter(const QByteArray &eventType, void *message,
+                                       long *result)
+{
+    Q_UNUSED(result);
+    if (!m_grabbed || eventType != "xcb_generic_event_t") {
+        return false;
+    }
+    auto event = static_cast<xcb_generic_event_t *>(message);
+    if ((event->response_type & ~0x80) != XCB_KEY_PRESS) {
+        return false;
+    }
+    auto key = reinterpret_cast<xcb_key_press_event_t *>(event);
+    auto state = key->state & ~(XCB_MOD_MASK_LOCK | XCB_MOD_MASK_2);
+    if (key->detail == m_keycode && state == m_modifiers) {
+        emit activated();
+        return true;
+    }
+    return false;
+}
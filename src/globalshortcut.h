@@ -0,0 +1,47 @@
+#ifndef GLOBALSHORTCUT_H
+#define GLOBALSHORTCUT_H
+
+#include <QAbstractNativeEventFilter>
+#include <QKeySequence>
+#include <QObject>
+#include <QVector>
+
+/*
+ * 全局快捷键。在根窗口上用 xcb_grab_key 抓取绑定的组合键，
+ * X 服务器只在按下这个组合时才会发事件过来，其它按键不会唤醒进程。
+ * 绑定保存在 QSettings 的 hotkey/showWindow 中，空字符串表示不绑定。
+ */
+class GlobalShortcut : public QObject, public QAbstractNativeEventFilter
+{
+    Q_OBJECT
+
+public:
+    static GlobalShortcut *instance();
+    ~GlobalShortcut() override;
+
+    QKeySequence shortcut() const { return m_sequence; }
+    // 重新绑定并保存到配置，失败（比如被其它程序占用）时返回 false。
+    // 空的组合键表示不使用快捷键
+    bool setShortcut(const QKeySequence &sequence);
+    // 读取配置中的绑定
+    bool reload();
+
+    bool nativeEventFilter(const QByteArray &eventType, void *message,
+                           long *result) override;
+
+signals:
+    void activated();
+
+private:
+    explicit GlobalShortcut(QObject *parent = nullptr);
+    bool grab(const QKeySequence &sequence);
+    void ungrab();
+
+private:
+    QKeySequence m_sequence;
+    quint8 m_keycode{0};
+    quint16 m_modifiers{0};
+    bool m_grabbed{false};
+};
+
+#endif // GLOBALSHORTCUT_H
@@ -0,0 +1,172 @@
+#include "indexprogress.h"
+
+#include <QFileInfo>
+#include <QStringList>
+
+#include <algorithm>
+#include <vector>
+
+#include <conftree.h>
+#include <indexer.h>
+#include <rclconfig.h>
+
+extern RclConfig *theconfig;
+
+// idxstatus 文件超过这么久没有更新就认为外部索引已经结束
+static const int staleStatusSecs = 15;
+
+static QString phaseName(int phase)
+{
+    switch (phase) {
+    case DbIxStatus::DBIXS_FILES:
+        return "files";
+    case DbIxStatus::DBIXS_PURGE:
+        return "purge";
+    case DbIxStatus::DBIXS_STEMDB:
+        return "stemdb";
+    case DbIxStatus::DBIXS_CLOSING:
+        return "closing";
+    case DbIxStatus::DBIXS_MONITOR:
+        return "monitor";
+    case DbIxStatus::DBIXS_DONE:
+        return "done";
+    default:
+        return "none";
+    }
+}
+
+QVariantMap IndexProgress::toVariantMap() const
+{
+    QVariantMap map;
+    map["source"] = source == SRC_WORKER ? "worker"
+                    : source == SRC_IDXSTATUS ? "idxstatus" : "none";
+    map["active"] = active;
+    map["phase"] = phase;
+    map["filesSeen"] = filesSeen;
+    map["filesIndexed"] = filesIndexed;
+    map["filesWithoutDocs"] = filesWithoutDocs;
+    map["fileErrors"] = fileErrors;
+    map["totalFiles"] = totalFiles;
+    map["bytesProcessed"] = bytesProcessed;
+    map["currentFile"] = currentFile;
+    map["elapsedMs"] = elapsedMs;
+    map["etaSecs"] = etaSecs;
+    QVariantMap filters;
+    for (auto it = filterMs.constBegin(); it != filterMs.constEnd(); ++it) {
+        QVariantMap one;
+        one["ms"] = it.value();
+        one["files"] = filterFiles.value(it.key());
+        filters[it.key()] = one;
+    }
+    map["filters"] = filters;
+    return map;
+}
+
+QString IndexProgress::summary() const
+{
+    if (!active) {
+        return QObject::tr("索引空闲");
+    }
+    QString text = QObject::tr("正在索引: %1/%2 个文件").arg(filesSeen).arg(totalFiles);
+    if (etaSecs >= 0) {
+        text += QObject::tr("，剩余约 %1 秒").arg(etaSecs);
+    }
+    if (!currentFile.isEmpty()) {
+        text += "\n" + QFileInfo(currentFile).fileName();
+    }
+    return text;
+}
+
+QString IndexProgress::filterReport(int maxLines) const
+{
+    std::vector<std::pair<qint64, QString>> sorted;
+    for (auto it = filterMs.constBegin(); it != filterMs.constEnd(); ++it) {
+        sorted.emplace_back(it.value(), it.key());
+    }
+    std::sort(sorted.rbegin(), sorted.rend());
+    QStringList lines;
+    for (const auto &entry : sorted) {
+        if (lines.size() >= maxLines) {
+            break;
+        }
+        lines << QString("%1: %2 ms / %3").arg(entry.second).arg(entry.first)
+                 .arg(filterFiles.value(entry.second));
+    }
+    return lines.join("\n");
+}
+
+IndexProgressMonitor::IndexProgressMonitor(QObject *parent) : QObject(parent)
+{
+    qRegisterMetaType<IndexProgress>("IndexProgress");
+    m_pollTimer = new QTimer(this);
+    m_pollTimer->setInterval(1000);
+    connect(m_pollTimer, &QTimer::timeout, this, &IndexProgressMonitor::pollIdxStatus);
+}
+
+void IndexProgressMonitor::startPolling()
+{
+    m_pollTimer->start();
+}
+
+void IndexProgressMonitor::setWorkerProgress(const IndexProgress &progress)
+{
+    m_progress = progress;
+    emit progressChanged(m_progress);
+}
+
+void IndexProgressMonitor::pollIdxStatus()
+{
+    // 进程内索引的数据更准确
+    if (m_progress.source == IndexProgress::SRC_WORKER && m_progress.active) {
+        return;
+    }
+    if (theconfig == nullptr) {
+        return;
+    }
+    QFileInfo fi(QString::fromStdString(theconfig->getIdxStatusFile()));
+    if (!fi.exists() || fi.lastModified() == m_lastStatusMtime) {
+        if (m_progress.source == IndexProgress::SRC_IDXSTATUS && m_progress.active &&
+            fi.lastModified().secsTo(QDateTime::currentDateTime()) > staleStatusSecs) {
+            m_progress.active = false;
+            emit progressChanged(m_progress);
+        }
+        return;
+    }
+    m_lastStatusMtime = fi.lastModified();
+
+    ConfSimple cs(fi.absoluteFilePath().toStdString().c_str(), 1);
+    std::string val;
+    auto getInt = [&cs, &val](const char *key) {
+        return cs.get(key, val) ? atoi(val.c_str()) : 0;
+    };
+    IndexProgress p;
+    p.source = IndexProgress::SRC_IDXSTATUS;
+    int phase = getInt("phase");
+    p.phase = phaseName(phase);
+    p.active = phase != DbIxStatus::DBIXS_NONE && phase != DbIxStatus::DBIXS_DONE;
+    p.filesSeen = getInt("filesdone");
+    p.filesIndexed = getInt("docsdone");
+    p.fileErrors = getInt("fileerrors");
+    p.totalFiles = getInt("totfiles");
+    if (cs.get("fn", val)) {
+        p.currentFile = QString::fromStdString(val);
+    }
+
+    // 外部进程只能根据两次轮询之间的速度估计剩余时间
+    auto now = QDateTime::currentDateTime();
+    if (!p.active) {
+        m_firstPollDocs = -1;
+    } else if (m_firstPollDocs < 0 || p.filesSeen < m_firstPollDocs) {
+        m_firstPollDocs = p.filesSeen;
+        m_firstPollTime = now;
+    } else {
+        auto secs = m_firstPollTime.secsTo(now);
+        auto done = p.filesSeen - m_firstPollDocs;
+        p.elapsedMs = m_firstPollTime.msecsTo(now);
+        if (secs > 0 && done > 0 && p.totalFiles > p.filesSeen) {
+            p.etaSecs = qint64(p.totalFiles - p.filesSeen) * secs / done;
+        }
+    }
+    m_progress = p;
+    emit progressChanged(m_progress);
+}
@@ -0,0 +1,75 @@
+#ifndef INDEXPROGRESS_H
+#define INDEXPROGRESS_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QMetaType>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVariantMap>
+
+/*
+ * 索引进度的快照。来源可能是进程内的 IndexWorker，
+ * 也可能是外部 recollindex 写的 idxstatus 文件。
+ */
+struct IndexProgress {
+    enum Source { SRC_NONE, SRC_WORKER, SRC_IDXSTATUS };
+
+    Source source{SRC_NONE};
+    bool active{false};
+    QString phase;
+    int filesSeen{0};
+    int filesIndexed{0};
+    // 处理后没有产生新文档的文件：没有变化，或者被跳过。recoll 不区分这两种
+    int filesWithoutDocs{0};
+    int fileErrors{0};
+    int totalFiles{0};
+    qint64 bytesProcessed{0};
+    QString currentFile;
+    qint64 elapsedMs{0};
+    // -1 表示无法估计
+    qint64 etaSecs{-1};
+    // 每种过滤器（mimeconf 中的处理程序）花费的时间和处理的文件数
+    QHash<QString, qint64> filterMs;
+    QHash<QString, int> filterFiles;
+
+    QVariantMap toVariantMap() const;
+    // 一两行的简短描述，用于托盘提示
+    QString summary() const;
+    // 按耗时排序的过滤器列表
+    QString filterReport(int maxLines = 8) const;
+};
+Q_DECLARE_METATYPE(IndexProgress)
+
+/*
+ * 汇总索引进度。进程内索引时直接接收 IndexWorker 的快照，
+ * 否则轮询 recoll 的 idxstatus 文件（外部 recollindex 在运行时）。
+ */
+class IndexProgressMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit IndexProgressMonitor(QObject *parent = nullptr);
+
+    const IndexProgress &current() const { return m_progress; }
+
+public slots:
+    void setWorkerProgress(const IndexProgress &progress);
+    void startPolling();
+
+signals:
+    void progressChanged(const IndexProgress &progress);
+
+private slots:
+    void pollIdxStatus();
+
+private:
+    IndexProgress m_progress;
+    QTimer *m_pollTimer;
+    QDateTime m_lastStatusMtime;
+    qint64 m_firstPollDocs{-1};
+    QDateTime m_firstPollTime;
+};
+
+#endif // INDEXPROGRESS_H
@@ -0,0 +1,224 @@
+#include "indexqueue.h"
+
+#include <QDebug>
+#include <QFileInfo>
+
+// 队列中最多保留的条目数
+static const int maxQueueSize = 20000;
+// 同一目录下超过这么多文件就改成扫描整个目录
+static const int dirCollapseThreshold = 256;
+// 每一批的目标耗时
+static const int targetBatchMs = 1000;
+static const int minBatchSize = 32;
+static const int maxBatchSize = 4096;
+static const int minFlushMs = 50;
+static const int maxFlushMs = 2000;
+
+static QString parentOf(const QString &path)
+{
+    auto idx = path.lastIndexOf('/');
+    return idx <= 0 ? QString("/") : path.left(idx);
+}
+
+IndexQueue::IndexQueue(QObject *parent)
+    : QObject(parent), m_batchSize(256), m_flushIntervalMs(100)
+{
+    m_clock.start();
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    connect(m_flushTimer, &QTimer::timeout, this, &IndexQueue::ready);
+}
+
+void IndexQueue::enqueueChanged(const QStringList &paths)
+{
+    enqueue(m_changed, m_deleted, paths);
+    collapse(m_changed);
+    scheduleFlush();
+}
+
+void IndexQueue::enqueueDeleted(const QStringList &paths)
+{
+    enqueue(m_deleted, m_changed, paths);
+    if (m_deleted.size() > maxQueueSize) {
+        // 完整的增量索引会清理掉已经不存在的文件
+        requestFullPass();
+        return;
+    }
+    scheduleFlush();
+}
+
+void IndexQueue::requestFullPass(bool inPlaceReset)
+{
+    if (!m_fullPassPending) {
+        m_fullPasses++;
+    }
+    m_fullPassPending = true;
+    m_resetPending = m_resetPending || inPlaceReset;
+    m_coalesced += depth();
+    m_changed.clear();
+    m_deleted.clear();
+    scheduleFlush();
+}
+
+void IndexQueue::enqueue(QHash<QString, qint64> &set,
+                         QHash<QString, qint64> &other,
+                         const QStringList &paths)
+{
+    auto now = m_clock.elapsed();
+    for (const auto &path : paths) {
+        m_enqueued++;
+        if (m_fullPassPending) {
+            m_coalesced++;
+            continue;
+        }
+        other.remove(path);
+        // 已经在等待重新扫描的目录下面的文件不用再单独处理
+        bool covered = false;
+        for (auto dir = parentOf(path); dir != "/"; dir = parentOf(dir)) {
+            if (set.contains(dir)) {
+                covered = true;
+                break;
+            }
+        }
+        if (covered || set.contains(path)) {
+            m_coalesced++;
+            continue;
+        }
+        set.insert(path, now);
+    }
+}
+
+void IndexQueue::collapse(QHash<QString, qint64> &set)
+{
+    if (m_fullPassPending) {
+        return;
+    }
+    int threshold = dirCollapseThreshold;
+    // 一级一级向上合并，直到队列放得下
+    for (int level = 0; level < 8; level++) {
+        QHash<QString, int> perDir;
+        for (auto it = set.constBegin(); it != set.constEnd(); ++it) {
+            perDir[parentOf(it.key())]++;
+        }
+        bool changed = false;
+        for (auto dit = perDir.constBegin(); dit != perDir.constEnd(); ++dit) {
+            if (dit.value() < threshold || dit.key() == "/") {
+                continue;
+            }
+            auto dir = dit.key();
+            qint64 oldest = m_clock.elapsed();
+            for (auto it = set.begin(); it != set.end();) {
+                if (parentOf(it.key()) == dir) {
+                    oldest = qMin(oldest, it.value());
+                    it = set.erase(it);
+                    m_coalesced++;
+                } else {
+                    ++it;
+                }
+            }
+            set.insert(dir, oldest);
+            m_collapsedDirs++;
+            changed = true;
+        }
+        if (set.size() <= maxQueueSize) {
+            return;
+        }
+        // 还是太多，降低阈值继续向上合并
+        threshold = qMax(2, threshold / 4);
+        if (!changed && threshold == 2) {
+            break;
+        }
+    }
+    if (set.size() > maxQueueSize) {
+        qDebug() << "IndexQueue: overflow, falling back to a full pass";
+        requestFullPass();
+    }
+}
+
+void IndexQueue::scheduleFlush()
+{
+    if (!m_fullPassPending && depth() == 0) {
+        return;
+    }
+    auto wait = (m_fullPassPending || depth() >= m_batchSize) ? 0 : m_flushIntervalMs;
+    if (!m_flushTimer->isActive() || m_flushTimer->remainingTime() > wait) {
+        m_flushTimer->start(wait);
+    }
+}
+
+QStringList IndexQueue::takeFrom(QHash<QString, qint64> &set, int count)
+{
+    QStringList out;
+    auto now = m_clock.elapsed();
+    for (auto it = set.begin(); it != set.end() && out.size() < count;) {
+        auto latency = double(now - it.value());
+        m_avgLatencyMs = m_avgLatencyMs == 0 ? latency
+                                             : 0.9 * m_avgLatencyMs + 0.1 * latency;
+        out << it.key();
+        it = set.erase(it);
+    }
+    return out;
+}
+
+IndexQueue::Batch IndexQueue::takeBatch()
+{
+    Batch batch;
+    if (m_fullPassPending) {
+        m_fullPassPending = false;
+        batch.full = true;
+        batch.reset = m_resetPending;
+        m_resetPending = false;
+    } else if (!m_deleted.isEmpty()) {
+        batch.purge = true;
+        batch.paths = takeFrom(m_deleted, m_batchSize);
+    } else {
+        batch.paths = takeFrom(m_changed, m_batchSize);
+    }
+    return batch;
+}
+
+void IndexQueue::batchDone(const Batch &batch, qint64 elapsedMs, int files)
+{
+    m_batches++;
+    m_lastBatchMs = elapsedMs;
+    m_lastBatchSize = files;
+    if (!batch.full && files > 0 && elapsedMs > 0) {
+        double rate = files * 1000.0 / elapsedMs;
+        m_filesPerSec = m_filesPerSec == 0 ? rate : 0.7 * m_filesPerSec + 0.3 * rate;
+        m_batchSize = qBound(minBatchSize, int(m_filesPerSec * targetBatchMs / 1000),
+                             maxBatchSize);
+        // 慢的时候多等一会，让每次提交带上更多文件
+        m_flushIntervalMs = qBound(minFlushMs, int(elapsedMs / 2), maxFlushMs);
+    }
+    scheduleFlush();
+}
+
+QVariantMap IndexQueue::stats() const
+{
+    QVariantMap map;
+    map["depth"] = depth();
+    map["pendingChanged"] = m_changed.size();
+    map["pendingDeleted"] = m_deleted.size();
+    map["fullPassPending"] = m_fullPassPending;
+    qint64 oldest = 0;
+    auto now = m_clock.elapsed();
+    for (auto ts : m_changed) {
+        oldest = qMax(oldest, now - ts);
+    }
+    for (auto ts : m_deleted) {
+        oldest = qMax(oldest, now - ts);
+    }
+    map["oldestPendingMs"] = oldest;
+    map["avgQueueLatencyMs"] = m_avgLatencyMs;
+    map["batchSize"] = m_batchSize;
+    map["flushIntervalMs"] = m_flushIntervalMs;
+    map["filesPerSec"] = m_filesPerSec;
+    map["lastBatchSize"] = m_lastBatchSize;
+    map["lastBatchMs"] = m_lastBatchMs;
+    map["enqueued"] = m_enqueued;
+    map["coalesced"] = m_coalesced;
+    map["collapsedDirs"] = m_collapsedDirs;
+    map["fullPasses"] = m_fullPasses;
+    map["batches"] = m_batches;
+    return map;
+}
@@ -0,0 +1,78 @@
+#ifndef INDEXQUEUE_H
+#define INDEXQUEUE_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <QVariantMap>
+
+/*
+ * 等待索引的文件队列。
+ * 队列大小有上限：同一个目录下待处理的文件过多时合并成对这个目录的重新扫描，
+ * 仍然放不下时一级一级向上合并，最后退化成一次完整的增量索引。
+ * 每批的大小和等待时间根据实际测得的索引速度调整。
+ */
+class IndexQueue : public QObject
+{
+    Q_OBJECT
+public:
+    struct Batch {
+        QStringList paths;
+        bool purge{false};
+        bool full{false};
+        // 完整索引时把所有文件当作已修改（recollindex -Z）
+        bool reset{false};
+        bool isEmpty() const { return !full && paths.isEmpty(); }
+    };
+
+    explicit IndexQueue(QObject *parent = nullptr);
+
+    void enqueueChanged(const QStringList &paths);
+    void enqueueDeleted(const QStringList &paths);
+    void requestFullPass(bool inPlaceReset = false);
+
+    // 取出下一批，删除优先
+    Batch takeBatch();
+    // 一批完成后调用，用来估计吞吐量。files 是实际处理的文件数，
+    // 合并成目录的批次比 paths 多
+    void batchDone(const Batch &batch, qint64 elapsedMs, int files);
+
+    int depth() const { return m_changed.size() + m_deleted.size(); }
+    QVariantMap stats() const;
+
+signals:
+    // 等待时间到了，可以开始下一批
+    void ready();
+
+private:
+    void enqueue(QHash<QString, qint64> &set, QHash<QString, qint64> &other,
+                 const QStringList &paths);
+    void collapse(QHash<QString, qint64> &set);
+    void scheduleFlush();
+    QStringList takeFrom(QHash<QString, qint64> &set, int count);
+
+private:
+    // 路径 -> 入队时间
+    QHash<QString, qint64> m_changed;
+    QHash<QString, qint64> m_deleted;
+    bool m_fullPassPending{false};
+    bool m_resetPending{false};
+    QElapsedTimer m_clock;
+    QTimer *m_flushTimer;
+
+    int m_batchSize;
+    int m_flushIntervalMs;
+    double m_filesPerSec{0};
+    double m_avgLatencyMs{0};
+    qint64 m_lastBatchMs{0};
+    int m_lastBatchSize{0};
+    quint64 m_enqueued{0};
+    quint64 m_coalesced{0};
+    quint64 m_collapsedDirs{0};
+    quint64 m_fullPasses{0};
+    quint64 m_batches{0};
+};
+
+#endif // INDEXQUEUE_H
@@ -1,8 +1,11 @@
 #include "indexsche.h"
+#include "indexscheduler.h"
 
 #include <QFormLayout>
 #include <QGroupBox>
 #include <QLabel>
+#include <QMessageBox>
+#include <QSettings>
 #include <QVBoxLayout>
 
 IndexSche::IndexSche(QWidget *parent) : QWidget(parent)
@@ -12,10 +15,13 @@ IndexSche::IndexSche(QWidget *parent) : QWidget(parent)
     this->lbCronWeek=new QLineEdit();
     this->btnDisable=new QPushButton(tr("Disable"));
     this->btnEnable=new QPushButton(tr("Enable"));
+    this->ckbFullPass=new QCheckBox();
+    this->lbStatus=new QLabel();
     this->ckbStartNew=new QCheckBox();
     this->ckbStartOnStart=new QCheckBox();
 
     init_ui();
+    read_settings();
     init_conn();
 }
 
@@ -28,15 +34,17 @@ void IndexSche::init_ui()
     auto formLayoutCron=new QFormLayout();
     groupCron->setLayout(formLayoutCron);
 
-    formLayoutCron->addWidget(new QLabel("xxx"));
+    formLayoutCron->addRow(new QLabel(tr("与 cron 相同的写法，例如 *、1-5、0,30、*/15。"
+                                         "正在输入、使用电池或负载高时会推迟。")));
     formLayoutCron->addRow(tr("星期"),this->lbCronWeek);
     formLayoutCron->addRow(tr("小时"),this->lbCronHour);
     formLayoutCron->addRow(tr("分钟"),this->lbCronMinu);
+    formLayoutCron->addRow(tr("完整重建"),this->ckbFullPass);
 
     auto hlayout=new QHBoxLayout();
     hlayout->addWidget(this->btnEnable);
     hlayout->addWidget(this->btnDisable);
-    formLayoutCron->addWidget(new QLabel("xxx"));
+    formLayoutCron->addRow(this->lbStatus);
     formLayoutCron->addRow(hlayout);
 
     auto groupRealtim=new QGroupBox(tr("RealTime"));
@@ -44,31 +52,57 @@ void IndexSche::init_ui()
 
     auto formLayout=new QFormLayout();
     groupRealtim->setLayout(formLayout);
-    formLayout->addWidget(new QLabel(tr("aaa")));
+    formLayout->addRow(new QLabel(tr("监控索引目录，文件变化后立即更新索引。")));
 
-
-    this->ckbStartNew->setEnabled(false);
-    formLayout->addRow(this->ckbStartOnStart,new QLabel("Start On System Start"));
+    formLayout->addRow(this->ckbStartOnStart,new QLabel(tr("Start On System Start")));
     formLayout->addRow(this->ckbStartNew,new QLabel(tr("Start Now")));
 
 }
 
+void IndexSche::read_settings()
+{
+    QSettings s;
+    this->lbCronWeek->setText(s.value(IndexScheduler::keyWeek,"*").toString());
+    this->lbCronHour->setText(s.value(IndexScheduler::keyHour,"3").toString());
+    this->lbCronMinu->setText(s.value(IndexScheduler::keyMinute,"0").toString());
+    this->ckbFullPass->setChecked(s.value(IndexScheduler::keyFullPass,false).toBool());
+    auto enabled=s.value(IndexScheduler::keyEnabled,false).toBool();
+    this->lbStatus->setText(enabled?tr("定时索引已启用"):tr("定时索引未启用"));
+    this->ckbStartOnStart->setChecked(IndexScheduler::instance()->realtimeOnStart());
+    this->ckbStartNew->setChecked(this->ckbStartOnStart->isChecked());
+}
+
+void IndexSche::save_cron(bool enabled)
+{
+    QSettings s;
+    s.setValue(IndexScheduler::keyWeek,this->lbCronWeek->text().trimmed());
+    s.setValue(IndexScheduler::keyHour,this->lbCronHour->text().trimmed());
+    s.setValue(IndexScheduler::keyMinute,this->lbCronMinu->text().trimmed());
+    s.setValue(IndexScheduler::keyFullPass,this->ckbFullPass->isChecked());
+    s.setValue(IndexScheduler::keyEnabled,enabled);
+    IndexScheduler::instance()->reload();
+    this->lbStatus->setText(enabled?tr("定时索引已启用"):tr("定时索引未启用"));
+}
+
 void IndexSche::init_conn()
 {
-    connect(this->btnEnable,&QPushButton::clicked,[](){
-        //TODO
+    connect(this->btnEnable,&QPushButton::clicked,[this](){
+        CronSpec spec;
+        if(!spec.parse(this->lbCronWeek->text(),this->lbCronHour->text(),
+                       this->lbCronMinu->text())){
+            QMessageBox::warning(this,tr("格式错误"),tr("无法解析定时设置"));
+            return;
+        }
+        save_cron(true);
     });
-    connect(this->btnDisable,&QPushButton::clicked,[](){
-        //TODO
+    connect(this->btnDisable,&QPushButton::clicked,[this](){
+        save_cron(false);
     });
-    connect(this->ckbStartNew,&QCheckBox::toggled,[](){
-
+    connect(this->ckbStartNew,&QCheckBox::toggled,[](bool checked){
+        IndexScheduler::instance()->setRealtime(checked);
     });
-    connect(this->ckbStartOnStart,&QCheckBox::toggled,[this](bool checked){
-        if(checked){
-            this->ckbStartNew->setEnabled(true);
-        }
-
+    connect(this->ckbStartOnStart,&QCheckBox::toggled,[](bool checked){
+        QSettings().setValue(IndexScheduler::keyRealtimeOnStart,checked);
     });
 
 }
@@ -2,6 +2,7 @@
 #define INDEXSCHE_H
 
 #include <QCheckBox>
+#include <QLabel>
 #include <QLineEdit>
 #include <QPushButton>
 #include <QWidget>
@@ -16,12 +17,16 @@ private:
 
     void init_ui();
     void init_conn();
+    void read_settings();
+    void save_cron(bool enabled);
 private:
     QLineEdit *lbCronWeek;
     QLineEdit *lbCronHour;
     QLineEdit *lbCronMinu;
     QPushButton *btnEnable;
     QPushButton *btnDisable;
+    QCheckBox	*ckbFullPass;
+    QLabel	*lbStatus;
     QCheckBox	*ckbStartOnStart;
     QCheckBox	*ckbStartNew;
 
@@ -0,0 +1,258 @@
+#include "indexscheduler.h"
+
+#include <QApplication>
+#include <QDebug>
+#include <QDir>
+#include <QEvent>
+#include <QFile>
+#include <QSettings>
+#include <QStringList>
+#include <QThread>
+
+#include <cstdlib>
+
+// 最后一次按键后多久内认为用户还在输入
+static const int typingIdleMs = 30 * 1000;
+// 1 分钟平均负载超过 CPU 数的这个比例就暂停
+static const double highLoadRatio = 0.8;
+static const int tickMs = 15 * 1000;
+
+const char *IndexScheduler::keyEnabled = "sched/enabled";
+const char *IndexScheduler::keyWeek = "sched/week";
+const char *IndexScheduler::keyHour = "sched/hour";
+const char *IndexScheduler::keyMinute = "sched/minute";
+const char *IndexScheduler::keyFullPass = "sched/fullPass";
+const char *IndexScheduler::keyRealtimeOnStart = "realtime/startOnStart";
+
+bool CronSpec::parseField(const QString &text, int min, int max,
+                          std::bitset<64> &out)
+{
+    out.reset();
+    auto trimmed = text.trimmed();
+    if (trimmed.isEmpty()) {
+        return false;
+    }
+    for (const auto &part : trimmed.split(',')) {
+        auto item = part.trimmed();
+        int step = 1;
+        auto slash = item.indexOf('/');
+        if (slash >= 0) {
+            bool ok;
+            step = item.mid(slash + 1).toInt(&ok);
+            if (!ok || step <= 0) {
+                return false;
+            }
+            item = item.left(slash);
+        }
+        int from, to;
+        if (item == "*") {
+            from = min;
+            to = max;
+        } else {
+            auto dash = item.indexOf('-');
+            bool ok1, ok2 = true;
+            if (dash >= 0) {
+                from = item.left(dash).toInt(&ok1);
+                to = item.mid(dash + 1).toInt(&ok2);
+            } else {
+                from = to = item.toInt(&ok1);
+                if (slash >= 0) {
+                    to = max;
+                }
+            }
+            if (!ok1 || !ok2 || from < min || to > max || from > to) {
+                return false;
+            }
+        }
+        for (int i = from; i <= to; i += step) {
+            out.set(i);
+        }
+    }
+    return true;
+}
+
+bool CronSpec::parse(const QString &week, const QString &hour, const QString &minute)
+{
+    m_valid = parseField(week, 0, 7, m_week) && parseField(hour, 0, 23, m_hour) &&
+              parseField(minute, 0, 59, m_minute);
+    if (m_week.test(7)) {
+        m_week.set(0);
+    }
+    return m_valid;
+}
+
+bool CronSpec::matches(const QDateTime &time) const
+{
+    if (!m_valid) {
+        return false;
+    }
+    // Qt 中周一为 1，周日为 7
+    return m_week.test(time.date().dayOfWeek() % 7) &&
+           m_hour.test(time.time().hour()) && m_minute.test(time.time().minute());
+}
+
+IndexScheduler *IndexScheduler::instance()
+{
+    static auto instance = new IndexScheduler(qApp);
+    return instance;
+}
+
+IndexScheduler::IndexScheduler(QObject *parent) : QObject(parent)
+{
+    m_lastInput.start();
+    m_timer = new QTimer(this);
+    m_timer->setInterval(tickMs);
+    connect(m_timer, &QTimer::timeout, this, &IndexScheduler::tick);
+    qApp->installEventFilter(this);
+    reload();
+    m_timer->start();
+}
+
+void IndexScheduler::reload()
+{
+    QSettings s;
+    m_enabled = s.value(keyEnabled, false).toBool();
+    m_full = s.value(keyFullPass, false).toBool();
+    m_spec.parse(s.value(keyWeek, "*").toString(), s.value(keyHour, "3").toString(),
+                 s.value(keyMinute, "0").toString());
+    if (m_enabled && !m_spec.isValid()) {
+        qDebug() << "IndexScheduler: invalid cron spec, schedule disabled";
+    }
+}
+
+bool IndexScheduler::realtimeOnStart() const
+{
+    return QSettings().value(keyRealtimeOnStart, true).toBool();
+}
+
+void IndexScheduler::setRealtime(bool enabled)
+{
+    emit realtimeToggled(enabled);
+}
+
+bool IndexScheduler::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::KeyPress || event->type() == QEvent::InputMethod) {
+        m_lastInput.restart();
+        // 输入时立即让出，而不是等下一次检查。其它条件留给定时检查
+        if (m_state == ST_RUNNING && !m_pauseSent) {
+            qDebug() << "IndexScheduler: pausing scheduled pass: user typing";
+            m_pauseSent = true;
+            emit pauseRequested();
+        }
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+bool IndexScheduler::userTyping() const
+{
+    return m_lastInput.elapsed() < typingIdleMs;
+}
+
+bool IndexScheduler::onBattery()
+{
+    bool haveBattery = false;
+    QDir dir("/sys/class/power_supply");
+    for (const auto &name : dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QFile typeFile(dir.filePath(name + "/type"));
+        if (!typeFile.open(QFile::ReadOnly)) {
+            continue;
+        }
+        auto type = typeFile.readAll().trimmed();
+        if (type == "Mains") {
+            QFile online(dir.filePath(name + "/online"));
+            if (online.open(QFile::ReadOnly) && online.readAll().trimmed() == "1") {
+                return false;
+            }
+        } else if (type == "Battery") {
+            haveBattery = true;
+        }
+    }
+    return haveBattery;
+}
+
+bool IndexScheduler::highLoad()
+{
+    double load[1];
+    if (getloadavg(load, 1) != 1) {
+        return false;
+    }
+    return load[0] > QThread::idealThreadCount() * highLoadRatio;
+}
+
+bool IndexScheduler::canRunNow(QString *reason) const
+{
+    QString why;
+    if (userTyping()) {
+        why = "user typing";
+    } else if (onBattery()) {
+        why = "on battery";
+    } else if (highLoad()) {
+        why = "high load";
+    }
+    if (reason != nullptr) {
+        *reason = why;
+    }
+    return why.isEmpty();
+}
+
+void IndexScheduler::runNow(bool full)
+{
+    if (m_state == ST_IDLE) {
+        m_state = ST_PENDING;
+        m_pendingFull = full;
+    } else {
+        m_pendingFull = m_pendingFull || full;
+    }
+    tick();
+}
+
+void IndexScheduler::passFinished(bool ok, bool interrupted)
+{
+    if (m_state != ST_RUNNING) {
+        return;
+    }
+    if (ok) {
+        m_state = ST_IDLE;
+        return;
+    }
+    // 真正的错误重试也没用，等下一次时间表或者手动开始
+    if (!interrupted) {
+        qDebug() << "IndexScheduler: scheduled pass failed";
+        m_state = ST_IDLE;
+        return;
+    }
+    // 被中断的索引下一次继续，增量索引会跳过已经处理过的文件。
+    // 原地重置不记录进度，重来一次又要从头处理所有文件，
+    // 经常被打断时永远完成不了，所以之后改为增量索引
+    if (m_pendingFull) {
+        qDebug() << "IndexScheduler: in-place reset interrupted, continuing incrementally";
+        m_pendingFull = false;
+    }
+    m_state = ST_PENDING;
+}
+
+void IndexScheduler::tick()
+{
+    auto now = QDateTime::currentDateTime();
+    auto minute = now.toSecsSinceEpoch() / 60;
+    if (m_enabled && m_spec.matches(now) && minute != m_lastRunMinute) {
+        m_lastRunMinute = minute;
+        if (m_state == ST_IDLE) {
+            m_state = ST_PENDING;
+            m_pendingFull = m_full;
+        }
+    }
+
+    QString reason;
+    bool ok = canRunNow(&reason);
+    if (m_state == ST_PENDING && ok) {
+        m_state = ST_RUNNING;
+        m_pauseSent = false;
+        emit passDue(m_pendingFull);
+    } else if (m_state == ST_RUNNING && !ok) {
+        qDebug() << "IndexScheduler: pausing scheduled pass:" << reason;
+        m_pauseSent = true;
+        emit pauseRequested();
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef INDEXSCHEDULER_H
+#define INDEXSCHEDULER_H
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include <bitset>
+
+// cron 风格的时间表达式：星期、小时、分钟三个字段，
+// 每个字段支持 "*"、"1,3,5"、"1-5"、"*/15" 这几种写法，星期中 0 和 7 都是周日。
+class CronSpec {
+public:
+    bool parse(const QString &week, const QString &hour, const QString &minute);
+    bool matches(const QDateTime &time) const;
+    bool isValid() const { return m_valid; }
+
+    static bool parseField(const QString &text, int min, int max,
+                           std::bitset<64> &out);
+
+private:
+    std::bitset<64> m_week;
+    std::bitset<64> m_hour;
+    std::bitset<64> m_minute;
+    bool m_valid{false};
+};
+
+/*
+ * 按 IndexSche 面板里的设置定时做完整或增量索引。
+ * 用户正在输入、使用电池或者系统负载高的时候推迟，
+ * 已经开始的定时索引在负载升高或者用户开始输入时中断，之后再继续。
+ * 配置保存在 QSettings 中，这里每次检查时重新读取。
+ */
+class IndexScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    static IndexScheduler *instance();
+
+    // 设置的键
+    static const char *keyEnabled;
+    static const char *keyWeek;
+    static const char *keyHour;
+    static const char *keyMinute;
+    static const char *keyFullPass;
+    static const char *keyRealtimeOnStart;
+
+    bool realtimeOnStart() const;
+    bool canRunNow(QString *reason = nullptr) const;
+
+public slots:
+    void reload();
+    // 立即开始（设置界面里的按钮），仍然会等待合适的时机
+    void runNow(bool full);
+    void setRealtime(bool enabled);
+    // MainWindow 在定时索引结束后调用，interrupted 为 true 时是被 pauseRequested 中断的
+    void passFinished(bool ok, bool interrupted);
+
+signals:
+    void passDue(bool full);
+    void pauseRequested();
+    void realtimeToggled(bool enabled);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void tick();
+
+private:
+    explicit IndexScheduler(QObject *parent = nullptr);
+    bool userTyping() const;
+    static bool onBattery();
+    static bool highLoad();
+
+private:
+    enum State { ST_IDLE, ST_PENDING, ST_RUNNING };
+    State m_state{ST_IDLE};
+    bool m_pendingFull{false};
+    // 这一次运行已经发过 pauseRequested
+    bool m_pauseSent{false};
+    CronSpec m_spec;
+    bool m_enabled{false};
+    bool m_full{false};
+    QTimer *m_timer;
+    QElapsedTimer m_lastInput;
+    qint64 m_lastRunMinute{-1};
+};
+
+#endif // INDEXSCHEDULER_H
@@ -0,0 +1,292 @@
+#include "indexworker.h"
+#include "termdict.h"
+
+#include <QDebug>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+#include <list>
+#include <memory>
+#include <string>
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <indexer.h>
+#include <log.h>
+#include <mimetype.h>
+#include <pathut.h>
+#include <rcldb.h>
+#include <rclquery.h>
+#include <searchdata.h>
+#include <smallut.h>
+
+// linux/ioprio.h 没有导出到用户空间
+static const int ioprioClassIdle = 3;
+static const int ioprioWhoProcess = 1;
+static const int ioprioClassShift = 13;
+
+// 进度信号的最小间隔，避免把界面线程的事件队列塞满
+static const int progressIntervalMs = 100;
+// 两次导出补全词典之间的最短间隔
+static const int dictExportIntervalMs = 10 * 60 * 1000;
+
+class WorkerStatusUpdater : public DbIxStatusUpdater {
+public:
+    WorkerStatusUpdater(IndexWorker *worker, RclConfig *config)
+        : m_worker(worker), m_config(config) {
+    }
+
+    void begin() {
+        m_progress = IndexProgress();
+        m_progress.source = IndexProgress::SRC_WORKER;
+        m_progress.active = true;
+        m_progress.phase = "files";
+        m_passTimer.start();
+        m_emitTimer.start();
+        m_fileTimer.start();
+        m_docsAtFileStart = 0;
+        emit m_worker->statsUpdated(m_progress);
+    }
+
+    void end() {
+        accountCurrentFile();
+        m_progress.active = false;
+        m_progress.phase = "done";
+        m_progress.currentFile.clear();
+        m_progress.etaSecs = 0;
+        m_progress.elapsedMs = m_passTimer.elapsed();
+        emit m_worker->statsUpdated(m_progress);
+    }
+
+    // 返回 false 会让 recoll 中断当前的索引
+    bool update() override {
+        auto fn = QString::fromStdString(status.fn);
+        if (fn != m_progress.currentFile) {
+            // recoll 在开始处理一个文件前更新 fn，两次变化之间就是上一个文件的耗时
+            accountCurrentFile();
+            m_progress.currentFile = fn;
+            m_fileTimer.restart();
+            m_docsAtFileStart = status.docsdone;
+        }
+        m_progress.filesSeen = status.filesdone;
+        m_progress.filesIndexed = status.docsdone;
+        m_progress.fileErrors = status.fileerrors;
+        m_progress.totalFiles = status.totfiles;
+        m_progress.elapsedMs = m_passTimer.elapsed();
+        if (m_progress.filesSeen > 0 && m_progress.totalFiles > m_progress.filesSeen) {
+            m_progress.etaSecs = m_progress.elapsedMs *
+                    (m_progress.totalFiles - m_progress.filesSeen) /
+                    m_progress.filesSeen / 1000;
+        } else {
+            m_progress.etaSecs = -1;
+        }
+
+        if (m_emitTimer.elapsed() >= progressIntervalMs) {
+            m_emitTimer.restart();
+            emit m_worker->progress(status.filesdone, status.totfiles, fn);
+            emit m_worker->statsUpdated(m_progress);
+        }
+        return !m_worker->m_stopRequested;
+    }
+
+private:
+    void accountCurrentFile() {
+        if (m_progress.currentFile.isEmpty()) {
+            return;
+        }
+        auto filter = filterFor(m_progress.currentFile);
+        m_progress.filterMs[filter] += m_fileTimer.elapsed();
+        m_progress.filterFiles[filter]++;
+        if (status.docsdone == m_docsAtFileStart) {
+            // 没有产生新文档：没有变化或者被跳过
+            m_progress.filesWithoutDocs++;
+        } else {
+            m_progress.bytesProcessed += QFileInfo(m_progress.currentFile).size();
+        }
+    }
+
+    // 用 mimeconf 里的处理程序作为过滤器的名字，按后缀缓存
+    QString filterFor(const QString &path) {
+        auto suffix = QFileInfo(path).suffix().toLower();
+        auto it = m_filterBySuffix.constFind(suffix);
+        if (it != m_filterBySuffix.constEnd()) {
+            return it.value();
+        }
+        auto mtype = mimetype(path.toStdString(), nullptr, m_config, true);
+        auto def = m_config->getMimeHandlerDef(mtype);
+        std::vector<std::string> tokens;
+        stringToStrings(def, tokens);
+        QString name;
+        if (tokens.size() >= 2) {
+            name = QString::fromStdString(tokens[0] + " " + tokens[1]);
+        } else if (!tokens.empty()) {
+            name = QString::fromStdString(tokens[0]);
+        } else {
+            name = QString::fromStdString("(" + mtype + ")");
+        }
+        m_filterBySuffix.insert(suffix, name);
+        return name;
+    }
+
+    IndexWorker *m_worker;
+    RclConfig *m_config;
+    IndexProgress m_progress;
+    QElapsedTimer m_passTimer;
+    QElapsedTimer m_emitTimer;
+    QElapsedTimer m_fileTimer;
+    int m_docsAtFileStart{0};
+    QHash<QString, QString> m_filterBySuffix;
+};
+
+IndexWorker::IndexWorker(RclConfig *config, QObject *parent)
+    : QObject(parent), m_config(*config)
+{
+}
+
+IndexWorker::~IndexWorker() = default;
+
+void IndexWorker::applyIdlePriority()
+{
+    // 参数 0 表示当前线程
+    if (syscall(SYS_ioprio_set, ioprioWhoProcess, 0,
+                ioprioClassIdle << ioprioClassShift) != 0) {
+        qDebug() << "IndexWorker: ioprio_set failed";
+    }
+    struct sched_param param;
+    param.sched_priority = 0;
+    if (sched_setscheduler(0, SCHED_IDLE, &param) != 0) {
+        qDebug() << "IndexWorker: SCHED_IDLE not available";
+    }
+}
+
+bool IndexWorker::ensureIndexer()
+{
+    if (m_indexer) {
+        return true;
+    }
+    m_updater.reset(new WorkerStatusUpdater(this, &m_config));
+    m_indexer.reset(new ConfIndexer(&m_config, m_updater.get()));
+    return true;
+}
+
+void IndexWorker::finish(bool ok, bool changed, int files)
+{
+    m_updater->end();
+    if (changed) {
+        m_generation++;
+        m_dictDirty = true;
+    }
+    bool interrupted = !ok && m_stopRequested;
+    m_stopRequested = false;
+    emit indexingFinished(ok, interrupted, m_generation, files);
+}
+
+void IndexWorker::maybeExportTermDict(bool force)
+{
+    // 实时索引的小批量很频繁，词典最多每隔一段时间导出一次
+    if (!m_dictDirty ||
+        (!force && m_dictTimer.isValid() && m_dictTimer.elapsed() < dictExportIntervalMs)) {
+        return;
+    }
+    auto path = TermDict::defaultPath();
+    if (TermDict::build(&m_config, path)) {
+        m_dictDirty = false;
+        m_dictTimer.start();
+        emit termDictExported(path);
+    }
+}
+
+void IndexWorker::indexFiles(QStringList paths)
+{
+    if (paths.isEmpty() || !ensureIndexer()) {
+        return;
+    }
+    emit indexingStarted();
+    m_updater->begin();
+    std::list<std::string> files;
+    for (const auto &path : paths) {
+        files.push_back(path.toStdString());
+        // 队列把大量文件合并成了目录，这里展开，和 recollindex -r 一样
+        if (QFileInfo(path).isDir()) {
+            QDirIterator it(path, QDir::Files | QDir::Hidden | QDir::System,
+                            QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                files.push_back(it.next().toStdString());
+            }
+        }
+    }
+    // 一次调用只打开、提交、关闭一次写句柄
+    bool ok = m_indexer->indexFiles(files, ConfIndexer::IxFNone);
+    if (!ok) {
+        LOGERR("IndexWorker::indexFiles: failed for " << paths.size()
+               << " files\n");
+    }
+    finish(ok, true, int(files.size()));
+    maybeExportTermDict(false);
+}
+
+// 删除或移出的目录已经不在磁盘上了，从索引里找出它下面的文件。
+// 和 recoll 的 subtreelist 相同，只是整批共用一个只读的 Db；普通文件找不到结果
+static void addSubtrees(RclConfig *config, const QStringList &paths,
+                        std::list<std::string> &files)
+{
+    Rcl::Db db(config);
+    if (!db.open(Rcl::Db::DbRO)) {
+        LOGERR("IndexWorker::purgeFiles: cannot open db\n");
+        return;
+    }
+    for (const auto &path : paths) {
+        auto sdata = std::make_shared<Rcl::SearchData>(Rcl::SCLT_AND, "");
+        sdata->addClause(new Rcl::SearchDataClausePath(path.toStdString(), false));
+        Rcl::Query query(&db);
+        if (!query.setQuery(sdata)) {
+            continue;
+        }
+        int cnt = query.getResCnt();
+        for (int i = 0; i < cnt; i++) {
+            Rcl::Doc doc;
+            if (!query.getDoc(i, doc)) {
+                break;
+            }
+            auto file = fileurltolocalpath(doc.url);
+            if (!file.empty()) {
+                files.push_back(file);
+            }
+        }
+    }
+}
+
+void IndexWorker::purgeFiles(QStringList paths)
+{
+    if (paths.isEmpty() || !ensureIndexer()) {
+        return;
+    }
+    emit indexingStarted();
+    m_updater->begin();
+    std::list<std::string> files;
+    for (const auto &path : paths) {
+        files.push_back(path.toStdString());
+    }
+    addSubtrees(&m_config, paths, files);
+    bool ok = m_indexer->purgeFiles(files, ConfIndexer::IxFNone);
+    finish(ok, true, int(files.size()));
+}
+
+void IndexWorker::indexAll(bool inPlaceReset)
+{
+    // topdirs 等配置可能在界面上被修改过
+    m_config.updateMainConfig();
+    m_indexer.reset();
+    if (!ensureIndexer()) {
+        return;
+    }
+    emit indexingStarted();
+    m_updater->begin();
+    int flags = inPlaceReset ? ConfIndexer::IxFInPlaceReset : ConfIndexer::IxFNone;
+    bool ok = m_indexer->index(false, ConfIndexer::IxTAll, flags);
+    finish(ok, true, 0);
+    maybeExportTermDict(true);
+}
@@ -0,0 +1,72 @@
+#ifndef INDEXWORKER_H
+#define INDEXWORKER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QStringList>
+
+#include <atomic>
+#include <memory>
+
+#include <rclconfig.h>
+
+#include "indexprogress.h"
+
+class ConfIndexer;
+class WorkerStatusUpdater;
+
+/*
+ * 在进程内完成索引，代替每一批都启动一次 recollindex。
+ * 对象需要 moveToThread 到单独的线程，所有槽都在那个线程里执行。
+ * 持有自己的 RclConfig 副本，不和界面线程共享。
+ */
+class IndexWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit IndexWorker(RclConfig *config, QObject *parent = nullptr);
+    ~IndexWorker() override;
+
+    // 可以从任意线程调用，当前这一批处理完后停止
+    void requestStop() { m_stopRequested = true; }
+    quint64 generation() const { return m_generation; }
+
+public slots:
+    // 在索引线程启动后调用：CPU 和 IO 都使用空闲优先级，
+    // recoll 启动的外部过滤器也会继承
+    void applyIdlePriority();
+    void indexFiles(QStringList paths);
+    void purgeFiles(QStringList paths);
+    // 完整的增量索引，inPlaceReset 为 true 时相当于 recollindex -Z
+    void indexAll(bool inPlaceReset);
+
+signals:
+    void indexingStarted();
+    void progress(int filesDone, int totalFiles, QString current);
+    // 带有字节数、每个过滤器耗时等的完整进度
+    void statsUpdated(IndexProgress progress);
+    // 每完成一批发出一次，generation 增加说明数据库内容变了。
+    // interrupted 表示没有完成是因为 requestStop，而不是出错。
+    // files 是实际处理的文件数，合并成目录的路径展开后计算
+    void indexingFinished(bool ok, bool interrupted, quint64 generation, int files);
+    // 补全词典重新导出了
+    void termDictExported(QString path);
+
+private:
+    bool ensureIndexer();
+    void finish(bool ok, bool changed, int files);
+    void maybeExportTermDict(bool force);
+
+    friend class WorkerStatusUpdater;
+
+private:
+    RclConfig m_config;
+    std::unique_ptr<WorkerStatusUpdater> m_updater;
+    std::unique_ptr<ConfIndexer> m_indexer;
+    std::atomic<bool> m_stopRequested{false};
+    std::atomic<quint64> m_generation{0};
+    bool m_dictDirty{true};
+    QElapsedTimer m_dictTimer;
+};
+
+#endif // INDEXWORKER_H
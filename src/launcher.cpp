@@ -0,0 +1,492 @@
+#include "launcher.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QUrl>
+#include <XdgDirs>
+
+#include <rclconfig.h>
+
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+extern char **environ;
+extern RclConfig *theconfig;
+
+// 没有找到默认程序时的最后手段
+static const char *fallbackOpener = "xdg-open";
+static const char *terminalEmulator = "x-terminal-emulator";
+// 同时等待回收的子进程数，超过时退回到单独的线程
+static const int maxChildren = 256;
+
+// 启动的还没有退出的子进程，0 表示空位
+static std::atomic<pid_t> children[maxChildren];
+static struct sigaction previousSigchld;
+
+// 只回收自己启动的进程，QProcess 和 recoll 的过滤器进程由它们自己 waitpid。
+// 在信号处理函数里调用，只用 waitpid 和原子操作
+static void reapChildren()
+{
+    for (auto &slot : children) {
+        pid_t pid = slot.load();
+        if (pid <= 0) {
+            continue;
+        }
+        int status;
+        auto ret = waitpid(pid, &status, WNOHANG);
+        if (ret == pid || (ret < 0 && errno == ECHILD)) {
+            slot.compare_exchange_strong(pid, 0);
+        }
+    }
+}
+
+static void onSigchld(int sig, siginfo_t *info, void *context)
+{
+    auto savedErrno = errno;
+    reapChildren();
+    errno = savedErrno;
+    // Qt 的 forkfd 也依赖 SIGCHLD
+    if (previousSigchld.sa_flags & SA_SIGINFO) {
+        if (previousSigchld.sa_sigaction != nullptr) {
+            previousSigchld.sa_sigaction(sig, info, context);
+        }
+    } else if (previousSigchld.sa_handler != SIG_DFL && previousSigchld.sa_handler != SIG_IGN) {
+        previousSigchld.sa_handler(sig);
+    }
+}
+
+static void installSigchldHandler()
+{
+    static std::once_flag once;
+    std::call_once(once, []() {
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_sigaction = onSigchld;
+        action.sa_flags = SA_SIGINFO | SA_RESTART | SA_NOCLDSTOP;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGCHLD, &action, &previousSigchld);
+    });
+}
+
+static bool watchChild(pid_t pid)
+{
+    for (auto &slot : children) {
+        pid_t empty = 0;
+        if (slot.compare_exchange_strong(empty, pid)) {
+            // 登记之前可能已经退出了，SIGCHLD 已经错过
+            reapChildren();
+            return true;
+        }
+    }
+    return false;
+}
+
+Launcher *Launcher::instance()
+{
+    static auto instance = new Launcher;
+    return instance;
+}
+
+static QStringList mimeappsLists()
+{
+    // 按优先级从高到低
+    QStringList lists;
+    auto desktops = QString(qgetenv("XDG_CURRENT_DESKTOP")).toLower().split(':', QString::SkipEmptyParts);
+    QStringList dirs;
+    dirs << XdgDirs::configHome();
+    dirs << XdgDirs::configDirs();
+    dirs << XdgDirs::dataHome() + "/applications";
+    for (const auto &d : XdgDirs::dataDirs()) {
+        dirs << d + "/applications";
+    }
+    for (const auto &dir : dirs) {
+        for (const auto &desktop : desktops) {
+            lists << dir + "/" + desktop + "-mimeapps.list";
+        }
+        lists << dir + "/mimeapps.list";
+    }
+    return lists;
+}
+
+Launcher::DesktopEntry Launcher::parseDesktopFile(const QString &path)
+{
+    DesktopEntry entry;
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        return entry;
+    }
+    entry.path = path;
+    QTextStream in(&file);
+    in.setCodec("UTF-8");
+    bool inMain = false;
+    while (!in.atEnd()) {
+        auto line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        if (line.startsWith('[')) {
+            inMain = line == "[Desktop Entry]";
+            continue;
+        }
+        if (!inMain) {
+            continue;
+        }
+        auto eq = line.indexOf('=');
+        if (eq <= 0) {
+            continue;
+        }
+        auto key = line.left(eq).trimmed();
+        auto value = line.mid(eq + 1).trimmed();
+        if (key == "Exec") {
+            entry.exec = value;
+        } else if (key == "Name") {
+            entry.name = value;
+        } else if (key == "Icon") {
+            entry.icon = value;
+        } else if (key == "Path") {
+            entry.workDir = value;
+        } else if (key == "Terminal") {
+            entry.terminal = value == "true";
+        }
+    }
+    return entry;
+}
+
+// 字符串类型的值本身的转义：\s \n \t \r \\，在处理 Exec 的引号之前进行
+static QString unescapeString(const QString &value)
+{
+    QString out;
+    for (int i = 0; i < value.size(); i++) {
+        if (value[i] != '\\' || i + 1 >= value.size()) {
+            out += value[i];
+            continue;
+        }
+        auto c = value[++i];
+        if (c == 's') {
+            out += ' ';
+        } else if (c == 'n') {
+            out += '\n';
+        } else if (c == 't') {
+            out += '\t';
+        } else if (c == 'r') {
+            out += '\r';
+        } else if (c == '\\') {
+            out += '\\';
+        } else {
+            // 不认识的保持原样，留给引号规则处理
+            out += '\\';
+            out += c;
+        }
+    }
+    return out;
+}
+
+// Exec 的引号规则：双引号内 \" \` \$ \\ 需要转义，其它地方按空白分隔
+static QStringList splitExec(const QString &value)
+{
+    auto exec = unescapeString(value);
+    QStringList args;
+    QString cur;
+    bool quoted = false, haveArg = false;
+    for (int i = 0; i < exec.size(); i++) {
+        auto c = exec[i];
+        if (quoted) {
+            if (c == '\\' && i + 1 < exec.size()) {
+                cur += exec[++i];
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                cur += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+            haveArg = true;
+        } else if (c.isSpace()) {
+            if (haveArg || !cur.isEmpty()) {
+                args << cur;
+            }
+            cur.clear();
+            haveArg = false;
+        } else {
+            cur += c;
+        }
+    }
+    if (haveArg || !cur.isEmpty()) {
+        args << cur;
+    }
+    return args;
+}
+
+QStringList Launcher::expandExec(const DesktopEntry &entry, const QStringList &files)
+{
+    QStringList urls;
+    for (const auto &f : files) {
+        urls << QUrl::fromLocalFile(f).toString();
+    }
+    QStringList out;
+    bool filesUsed = false;
+    for (const auto &arg : splitExec(entry.exec)) {
+        // 单独出现的列表类代码展开成多个参数
+        if (arg == "%F" || arg == "%U") {
+            out << (arg == "%F" ? files : urls);
+            filesUsed = true;
+            continue;
+        }
+        if (arg == "%i") {
+            if (!entry.icon.isEmpty()) {
+                out << "--icon" << entry.icon;
+            }
+            continue;
+        }
+        QString expanded;
+        bool drop = false;
+        bool hasCode = false;
+        for (int i = 0; i < arg.size(); i++) {
+            if (arg[i] != '%' || i + 1 >= arg.size()) {
+                expanded += arg[i];
+                continue;
+            }
+            auto code = arg[++i].toLatin1();
+            hasCode = hasCode || code != '%';
+            switch (code) {
+            case '%':
+                expanded += '%';
+                break;
+            case 'f':
+            case 'F':
+                expanded += files.value(0);
+                drop = drop || files.isEmpty();
+                filesUsed = true;
+                break;
+            case 'u':
+            case 'U':
+                expanded += urls.value(0);
+                drop = drop || urls.isEmpty();
+                filesUsed = true;
+                break;
+            case 'c':
+                expanded += entry.name;
+                break;
+            case 'k':
+                expanded += entry.path;
+                break;
+            default:
+                // %d %D %n %N %v %m 已经废弃，直接去掉
+                break;
+            }
+        }
+        // 展开后为空的参数（比如没有名字时的 %c）去掉
+        if (!drop && !(hasCode && expanded.isEmpty())) {
+            out << expanded;
+        }
+    }
+    // mimeview 里的命令可能没有域代码
+    if (!filesUsed && !files.isEmpty() && entry.path.isEmpty()) {
+        out << files;
+    }
+    if (entry.terminal && !out.isEmpty()) {
+        out.prepend("-e");
+        out.prepend(terminalEmulator);
+    }
+    return out;
+}
+
+qint64 Launcher::spawn(const QStringList &argv, const QString &workDir)
+{
+    if (argv.isEmpty()) {
+        return -1;
+    }
+    QList<QByteArray> storage;
+    std::vector<char *> cargv;
+    for (const auto &a : argv) {
+        storage << a.toLocal8Bit();
+    }
+    for (auto &s : storage) {
+        cargv.push_back(s.data());
+    }
+    cargv.push_back(nullptr);
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+#ifdef POSIX_SPAWN_SETSID
+    // 和启动器的会话分开，启动器退出时不会带走子进程
+    flags |= POSIX_SPAWN_SETSID;
+#endif
+    posix_spawnattr_setflags(&attr, flags);
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    sigaddset(&defaults, SIGCHLD);
+    sigaddset(&defaults, SIGINT);
+    sigaddset(&defaults, SIGTERM);
+    sigaddset(&defaults, SIGHUP);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    auto dir = workDir.isEmpty() ? QDir::homePath() : workDir;
+    auto cdir = dir.toLocal8Bit();
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 29)
+    posix_spawn_file_actions_addchdir_np(&actions, cdir.constData());
+#endif
+
+    installSigchldHandler();
+    pid_t pid;
+    auto err = posix_spawnp(&pid, cargv[0], &actions, &attr, cargv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    if (err != 0) {
+        qWarning() << "Launcher: spawn" << argv << "failed:" << strerror(err);
+        return -1;
+    }
+    // 回收子进程，避免留下僵尸进程
+    if (!watchChild(pid)) {
+        std::thread([pid]() {
+            int status;
+            while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+            }
+        }).detach();
+    }
+    return pid;
+}
+
+bool Launcher::launchDesktopFile(const QString &desktopFile, const QString &exec)
+{
+    QElapsedTimer timer;
+    timer.start();
+    DesktopEntry entry;
+    if (exec.isEmpty()) {
+        entry = parseDesktopFile(desktopFile);
+    } else {
+        entry.path = desktopFile;
+        entry.exec = exec;
+    }
+    if (!entry.isValid()) {
+        qWarning() << "Launcher: no Exec in" << desktopFile;
+        return false;
+    }
+    auto pid = spawn(expandExec(entry, QStringList()), entry.workDir);
+    qDebug() << "Launcher:" << desktopFile << "pid" << pid << "in" << timer.elapsed() << "ms";
+    return pid > 0;
+}
+
+QString Launcher::findDesktopFile(const QString &id) const
+{
+    QStringList dirs;
+    dirs << XdgDirs::dataHome() + "/applications";
+    for (const auto &d : XdgDirs::dataDirs()) {
+        dirs << d + "/applications";
+    }
+    // desktop id 中的 - 可能对应子目录
+    auto sub = QString(id).replace('-', '/');
+    for (const auto &dir : dirs) {
+        if (QFile::exists(dir + "/" + id)) {
+            return dir + "/" + id;
+        }
+        if (sub != id && QFile::exists(dir + "/" + sub)) {
+            return dir + "/" + sub;
+        }
+    }
+    return QString();
+}
+
+void Launcher::reloadIfChanged()
+{
+    QDateTime stamp;
+    auto lists = mimeappsLists();
+    for (const auto &list : lists) {
+        QFileInfo fi(list);
+        if (fi.exists() && fi.lastModified() > stamp) {
+            stamp = fi.lastModified();
+        }
+    }
+    if (m_loaded && stamp == m_listsStamp) {
+        return;
+    }
+    m_loaded = true;
+    m_listsStamp = stamp;
+    m_handlers.clear();
+    m_defaults.clear();
+    // 逆序读取，高优先级的覆盖低优先级的
+    for (int i = lists.size() - 1; i >= 0; i--) {
+        QFile file(lists[i]);
+        if (!file.open(QFile::ReadOnly)) {
+            continue;
+        }
+        QTextStream in(&file);
+        QString group;
+        while (!in.atEnd()) {
+            auto line = in.readLine().trimmed();
+            if (line.startsWith('[')) {
+                group = line;
+                continue;
+            }
+            auto eq = line.indexOf('=');
+            if (group != "[Default Applications]" || eq <= 0) {
+                continue;
+            }
+            m_defaults[line.left(eq).trimmed()] =
+                line.mid(eq + 1).split(';', QString::SkipEmptyParts);
+        }
+    }
+}
+
+Launcher::DesktopEntry Launcher::handlerFor(const QString &mime)
+{
+    QMutexLocker locker(&m_mutex);
+    reloadIfChanged();
+    auto it = m_handlers.constFind(mime);
+    if (it != m_handlers.constEnd()) {
+        return it.value();
+    }
+    DesktopEntry entry;
+    for (const auto &id : m_defaults.value(mime)) {
+        auto path = findDesktopFile(id.trimmed());
+        if (!path.isEmpty()) {
+            entry = parseDesktopFile(path);
+            if (entry.isValid()) {
+                break;
+            }
+        }
+    }
+    if (!entry.isValid() && theconfig != nullptr) {
+        // recoll 的 mimeview，其中的 %f %u 和 desktop 文件的含义相同
+        auto def = theconfig->getMimeViewerDef(mime.toStdString(), "", false);
+        auto cmd = QString::fromStdString(def);
+        if (!cmd.isEmpty() && !cmd.startsWith(fallbackOpener)) {
+            entry.exec = cmd;
+        }
+    }
+    if (!entry.isValid()) {
+        entry.exec = QString(fallbackOpener) + " %f";
+    }
+    m_handlers.insert(mime, entry);
+    return entry;
+}
+
+bool Launcher::openFile(const QString &path, const QString &mime)
+{
+    QElapsedTimer timer;
+    timer.start();
+    auto entry = handlerFor(mime);
+    auto pid = spawn(expandExec(entry, QStringList() << path), QFileInfo(path).absolutePath());
+    qDebug() << "Launcher:" << path << "with" << entry.exec << "pid" << pid << "in"
+             << timer.elapsed() << "ms";
+    return pid > 0;
+}
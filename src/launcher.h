@@ -0,0 +1,57 @@
+#ifndef LAUNCHER_H
+#define LAUNCHER_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+/*
+ * 直接启动应用和打开文件，不经过 dex / xdg-open 脚本。
+ * 应用：解析 .desktop 的 Exec（优先使用索引中保存的 AppExec），展开域代码后 posix_spawn。
+ * 文件：按 mime 类型查找默认程序，来源依次是 mimeapps.list、recoll 的 mimeview，
+ * 结果缓存起来，mimeapps.list 修改后重新读取。
+ */
+class Launcher
+{
+public:
+    struct DesktopEntry {
+        QString path;
+        QString name;
+        QString icon;
+        QString exec;
+        QString workDir;
+        bool terminal{false};
+        bool isValid() const { return !exec.isEmpty(); }
+    };
+
+    static Launcher *instance();
+
+    // exec 为空时从 desktopFile 中读取
+    bool launchDesktopFile(const QString &desktopFile, const QString &exec = QString());
+    bool openFile(const QString &path, const QString &mime);
+
+    static DesktopEntry parseDesktopFile(const QString &path);
+    // 按 Desktop Entry 规范拆分 Exec 并展开 %f %u %i %c %k 等
+    static QStringList expandExec(const DesktopEntry &entry, const QStringList &files);
+    // 返回子进程 pid，失败返回 -1
+    static qint64 spawn(const QStringList &argv, const QString &workDir = QString());
+
+private:
+    Launcher() = default;
+    DesktopEntry handlerFor(const QString &mime);
+    void reloadIfChanged();
+    QString findDesktopFile(const QString &id) const;
+
+private:
+    QMutex m_mutex;
+    // mime -> 处理程序
+    QHash<QString, DesktopEntry> m_handlers;
+    // mime -> desktop id，来自 mimeapps.list
+    QHash<QString, QStringList> m_defaults;
+    QDateTime m_listsStamp;
+    bool m_loaded{false};
+};
+
+#endif // LAUNCHER_H
@@ -1,13 +1,18 @@
+#include <cstdio>
 #include <memory>
 #include <DApplication>
 #include <QDBusConnection>
+#include <QDBusConnectionInterface>
 #include <QDBusInterface>
 #include <QDebug>
 #include <QDesktopWidget>
 #include <QDir>
+#include <QFutureWatcher>
 #include <QMessageBox>
 #include <QStandardPaths>
 #include <QString>
+#include <QTimer>
+#include <QtConcurrent>
 #include <DTitlebar>
 #include <XdgDirs>
 #include <QProcess>
@@ -18,52 +23,17 @@
 #include "everylauncher_interface.h"
 #include "everylaunchermonitor_interface.h"
 #include "firsttimeinit.h"
-#include "keymonitor.h"
+#include "globalshortcut.h"
+#include "guiutils.h"
+#include "indexscheduler.h"
+#include "querytrace.h"
 #include "rclinit.h"
+#include "residentmode.h"
+#include "startuptrace.h"
 #include "systemtray.h"
+#include "textcache.h"
 #include "widget.h"
 
-const QString AppName = "EveryLauncher";
-const QString RECOLL_CONFIG_DIR = "recoll_conf";
-const QString RECOLL_CONFIG_FILE = "recoll.conf";
-const QString XAPIAN_DB_DIR = "xapiandb";
-const QString DBUS_SERVICE = "com.gitee.wanywhn.EveryLauncher";
-const QString DBUS_PATH = "/com/gitee/wanywhn/EveryLauncher";
-// QString DBUS_INTERFACE="com.gitee.wanywhn.EveryLauncher";
-const QString ORGANIZATION_NAME = "WANYWHN";
-
-const QString DBUS_MONITOR_SERVER ="com.gitee.wanywhn.EveryLauncherMonitor";
-const QString DBUS_MONITOR_PATH ="/com/gitee/wanywhn/EveryLauncherMonitor";
-//#define DBUS_INTERFACE "com.gitee.wanywhn.everylauncherMonitor"
-RclConfig *theconfig;
-std::shared_ptr<Rcl::Db> rcldb;
-
-/**
- * 打开数据库
- * @param reason 传出错误用参数
- * @param force 是否强制重新打开
- * @param maindberror 是否返回是主数据库打开错误
- * @return
- */
-bool maybeOpenDb(string &reason, bool force, bool *maindberror) {
-
-    if (force) {
-        rcldb = std::make_shared<Rcl::Db>(theconfig);
-    }
-    rcldb->rmQueryDb("");
-    Rcl::Db::OpenError error;
-    if (!rcldb->isopen() && !rcldb->open(Rcl::Db::DbRO, &error)) {
-        reason = "Could not open database";
-        if (maindberror) {
-            reason +=
-                    " in " + theconfig->getDbDir() + " wait for indexing to complete?";
-            *maindberror = error == Rcl::Db::DbOpenMainDb;
-        }
-        return false;
-    }
-    return true;
-}
-
 static void recollCleanup() {
     rcldb.reset();
     deleteZ(theconfig);
@@ -91,37 +61,66 @@ void _create_dirs() {
     }
 }
 
-int main(int argc, char *argv[]) {
-    DApplication::loadDXcbPlugin();
-    DApplication a(argc, argv);
-    DApplication::setApplicationName(AppName);
-    DApplication::setOrganizationName(AppName);
-    Dtk::Widget::DApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
-    Dtk::Widget::DApplication::setQuitOnLastWindowClosed(false);
-//    Dtk::Widget::DApplication::setApplicationName(AppName);
+/**
+ * 读取配置并打开数据库，在后台线程中执行
+ * @return 出错时返回错误信息
+ */
+static QString initBackend(bool prime) {
     _create_dirs();
-
-    MainWindow w;
-
-
+    StartupTrace::mark("create dirs", true);
     std::string reason;
     // TODO -c
     auto cfh=QDir(QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation)).absoluteFilePath(RECOLL_CONFIG_DIR);
     std::string confg =cfh.toStdString();
     theconfig = recollinit(0, recollCleanup, nullptr, reason, &confg);
     if (!theconfig || !theconfig->ok()) {
-        QString msg = "Configuration problem: ";
-        msg += QString::fromUtf8(reason.c_str());
-        QMessageBox::critical(nullptr, "Recoll", msg);
-        exit(1);
+        return "Configuration problem: " + QString::fromUtf8(reason.c_str());
     }
+    StartupTrace::mark("recollinit", true);
+    TextCache::instance()->setLocation(QString::fromStdString(theconfig->getDbDir()));
+    // 读取 recoll 界面设置，比如查询的词干语言
+    rwSettings(false);
     bool b;
     maybeOpenDb(reason, 1, &b);
-    //    fprintf(stderr, "recollinit done\n");
+    StartupTrace::mark("open db", true);
+    if (prime) {
+        ResidentMode::primeDb(rcldb.get());
+    }
+    return QString();
+}
+
+int main(int argc, char *argv[]) {
+    StartupTrace::begin();
+    DApplication::loadDXcbPlugin();
+    DApplication a(argc, argv);
+    DApplication::setApplicationName(AppName);
+    DApplication::setOrganizationName(AppName);
+    Dtk::Widget::DApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
+    Dtk::Widget::DApplication::setQuitOnLastWindowClosed(false);
+//    Dtk::Widget::DApplication::setApplicationName(AppName);
+    bool startupBench = a.arguments().contains("--startup-bench");
+    // 登录时常驻启动，窗口准备好但不显示，等待唤出
+    bool resident = a.arguments().contains("--resident");
+    ResidentMode::instance()->setResident(resident);
+    StartupTrace::mark("application");
+
     auto conn = QDBusConnection::sessionBus();
     if (!conn.isConnected()) {
         return -1;
     }
+    // 已经有实例在运行时不用再初始化任何东西
+    if (!startupBench && conn.interface()->isServiceRegistered(DBUS_SERVICE)) {
+        EveryLauncherInterface itface(DBUS_SERVICE, DBUS_PATH, conn);
+        itface.showWindow();
+        return 0;
+    }
+
+    // 先显示搜索框，配置和数据库在后台初始化
+    QFutureWatcher<QString> backend;
+    backend.setFuture(QtConcurrent::run(initBackend, resident));
+
+    MainWindow w;
+    StartupTrace::mark("main window");
 //  w.setWindowOpacity(0.1);
 //  w.setTranslucentBackground(true);
 //  w.setAttribute(Qt::WA_TranslucentBackground);
@@ -131,19 +130,23 @@ int main(int argc, char *argv[]) {
 
     DBusProxy proxy(SystemTray::getInstance(&w), w);
     EveryLauncherAdaptor adaptor(&proxy);
-    if (!conn.registerService(DBUS_SERVICE)) {
-        EveryLauncherInterface itface(DBUS_SERVICE, DBUS_PATH, conn);
-        itface.showWindow();
-        return 0;
-    } else {
+    if (!startupBench) {
+        if (!conn.registerService(DBUS_SERVICE)) {
+            EveryLauncherInterface itface(DBUS_SERVICE, DBUS_PATH, conn);
+            itface.showWindow();
+            return 0;
+        }
         conn.registerObject(DBUS_PATH, &proxy);
     }
+    if (!startupBench) {
+        auto hotkey = GlobalShortcut::instance();
+        QObject::connect(hotkey, &GlobalShortcut::activated,
+                         &SystemTray::getInstance(&w), &SystemTray::showWindow);
+        hotkey->reload();
+    }
 //    QObject::connect(&monitorItfc, &EveryLauncherMonitorInterface::fileWrited,
 //                     [](QStringList sl) { qDebug() << "get?" << sl;
 //                                        });
-    SystemTray::getInstance(&w).show();
-    QObject::connect(&SystemTray::getInstance(&w), &SystemTray::exitAll,
-                     []() { qApp->exit(); });
     auto desktop = QApplication::desktop();
     w.move((desktop->width() - w.width()) / 2,
            (desktop->height() - w.height()) / 3);
@@ -155,17 +158,77 @@ int main(int argc, char *argv[]) {
 
     w.setMinimumSize(fixdwid, fixhei);
     w.setMaximumSize(fixdwid, fixhei);
-    w.show();
-    QSettings s;
-    if(s.value("firstTime",true).toBool()){
-        firstTimeInit ftDialog(&w);
-        if(ftDialog.exec()!=QDialog::Accepted){
-            QMessageBox::warning(&w,QObject::tr("尚未索引"),QObject::tr("警告，尚未创建索引。可能无法搜索到东西。"));
-        }else{
-            s.setValue("firstTime",false);
 
+    // 第一次绘制和后台初始化都完成后才输出启动耗时
+    int pending = resident ? 1 : 2;
+    auto reportStartup = [&pending, startupBench]() {
+        if (--pending > 0) {
+            return;
+        }
+        if (startupBench || StartupTrace::enabled()) {
+            fprintf(stderr, "%s\n", StartupTrace::report().toUtf8().constData());
         }
+        if (startupBench) {
+            qApp->quit();
+        }
+    };
+    if (resident) {
+        ResidentMode::instance()->prepareWindow(&w);
+    } else {
+        StartupTrace::onFirstPaint(&w, [&reportStartup]() {
+            StartupTrace::mark("first paint");
+            reportStartup();
+        });
+        w.show();
+        StartupTrace::mark("show");
     }
 
+    QObject::connect(&backend, &QFutureWatcher<QString>::finished, [&]() {
+        auto error = backend.result();
+        if (!error.isEmpty()) {
+            QMessageBox::critical(nullptr, "Recoll", error);
+            exit(1);
+        }
+        // kill -USR1 导出最近的查询耗时。recollinit 在后台线程里也设置了 SIGUSR1，
+        // 等它结束再装，被换掉了就装回来
+        QueryTrace::installSignalHandler();
+        w.setBackendReady();
+        StartupTrace::mark("backend ready");
+        if (startupBench) {
+            reportStartup();
+            return;
+        }
+        if (IndexScheduler::instance()->realtimeOnStart()) {
+            w.startFsWatcher();
+        }
+        // 外部 recollindex（比如 cron 里的）写的 idxstatus
+        w.indexProgress()->startPolling();
+        SystemTray::getInstance(&w).setProgressMonitor(w.indexProgress());
+        SystemTray::getInstance(&w).show();
+        QObject::connect(&SystemTray::getInstance(&w), &SystemTray::exitAll,
+                         []() { qApp->exit(); });
+        reportStartup();
+        auto firstTime = [&w]() {
+            QSettings s;
+            if(s.value("firstTime",true).toBool()){
+                firstTimeInit ftDialog(&w, w.indexWorker());
+                if(ftDialog.exec()!=QDialog::Accepted){
+                    QMessageBox::warning(&w,QObject::tr("尚未索引"),QObject::tr("警告，尚未创建索引。可能无法搜索到东西。"));
+                }else{
+                    s.setValue("firstTime",false);
+
+                }
+            }
+        };
+        // 常驻模式下登录时不弹出对话框，等到第一次唤出窗口
+        if (resident && !w.isVisible()) {
+            StartupTrace::onFirstPaint(&w, [firstTime]() {
+                QTimer::singleShot(0, firstTime);
+            });
+        } else {
+            firstTime();
+        }
+    });
+
     return Dtk::Widget::DApplication::exec();
 }
@@ -12,19 +12,48 @@ int MSortFilterProxyModel::getMaxItemCount() const { return maxItemCount; }
 
 void MSortFilterProxyModel::setMaxItemCount(int value) {
   maxItemCount = value;
-  invalidateFilter();
+  refilter();
+}
+
+void MSortFilterProxyModel::setSourceModel(QAbstractItemModel *model) {
+  if (sourceModel()) {
+    disconnect(sourceModel(), nullptr, this, nullptr);
+  }
+  QSortFilterProxyModel::setSourceModel(model);
+  if (!model) {
+    return;
+  }
+  // QSortFilterProxyModel 只对变化的行调用 filterAcceptsRow，分组的状态会错
+  connect(model, &QAbstractItemModel::rowsInserted, this,
+          &MSortFilterProxyModel::refilter);
+  connect(model, &QAbstractItemModel::rowsRemoved, this,
+          &MSortFilterProxyModel::refilter);
+  connect(model, &QAbstractItemModel::rowsMoved, this,
+          &MSortFilterProxyModel::refilter);
+  connect(model, &QAbstractItemModel::dataChanged, this,
+          &MSortFilterProxyModel::refilter);
+  connect(model, &QAbstractItemModel::layoutChanged, this,
+          &MSortFilterProxyModel::refilter);
 }
 
 void MSortFilterProxyModel::resetPar() {
+  clearGroups();
+  maxItemCount=4;
+}
+
+void MSortFilterProxyModel::clearGroups() {
   currentGroupCount = 0;
   currentItemCount = 0;
   prevGroup="";
-  maxItemCount=4;
   mapidx.clear();
   setDot.clear();
   mapSections.clear();
   ommitTill=false;
+}
 
+void MSortFilterProxyModel::refilter() {
+  clearGroups();
+  invalidateFilter();
 }
 
 //!!FIXME qsortfilterproxymodel can only create index with row <than it accepted
@@ -36,7 +65,7 @@ bool MSortFilterProxyModel::filterAcceptsRow(
       return true;
   }
   auto lineGroup = sourceIndex
-                       .data(RecollModel::ModelRoles::Role_MIME_TYPE)
+                       .data(RecollModel::ModelRoles::Role_GROUP)
                        .toString();
 
   if(sourceIndex.data(RecollModel::ModelRoles::Role_NODISPLAY).toString().trimmed()=="true"){
@@ -16,12 +16,18 @@ public:
 
     int getMaxItemCount() const;
     void setMaxItemCount(int value);
+    void setSourceModel(QAbstractItemModel *model) override;
     public slots:
         void resetPar();
 
 protected:
     bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const override;
+private slots:
+    // 分组的状态是按行依次 filterAcceptsRow 时累积的，源模型有变化就从头再来
+    void refilter();
 private:
+    void clearGroups();
+
     int currentItemCount{0};
     int currentGroupCount{0};
     QString prevGroup;
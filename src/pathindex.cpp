@@ -0,0 +1,437 @@
+#include "pathindex.h"
+#include "docseqranked.h"
+#include "pathscan.h"
+#include "querytrace.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFuture>
+#include <QMimeDatabase>
+#include <QMutexLocker>
+#include <QSet>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+#include <dirent.h>
+#include <fnmatch.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <rclconfig.h>
+
+extern RclConfig *theconfig;
+
+static const char pathIndexMagic[4] = {'E', 'L', 'P', 'I'};
+static const quint32 pathIndexVersion = 1;
+static const quint32 noParent = 0xffffffff;
+static const quint32 flagDir = 1;
+// 超过这个时间的索引文件启动时重建
+static const qint64 maxAgeSecs = 24 * 3600;
+// 内存中的增删记录超过这么多就重建
+static const int maxOverlay = 20000;
+// 小于这个大小的缓冲区不分线程
+static const quint32 minChunk = 256 * 1024;
+static const int maxCandidates = 4096;
+static const int maxResults = 20;
+
+PathIndex::Snapshot::~Snapshot()
+{
+    if (base != nullptr) {
+        file.unmap(base);
+    }
+}
+
+QString PathIndex::Snapshot::path(quint32 node) const
+{
+    QStringList parts;
+    for (auto n = node; n != noParent; n = nodes[n].parent) {
+        parts.prepend(QString::fromUtf8(names + nodes[n].nameOff,
+                                        nodes[n + 1].nameOff - nodes[n].nameOff));
+    }
+    return parts.join('/');
+}
+
+QByteArray PathIndex::Snapshot::foldName(quint32 node) const
+{
+    // 去掉结尾的 \0
+    return QByteArray::fromRawData(fold + nodes[node].foldOff,
+                                   nodes[node + 1].foldOff - nodes[node].foldOff - 1);
+}
+
+quint32 PathIndex::Snapshot::nodeAt(quint32 pos) const
+{
+    auto it = std::upper_bound(nodes, nodes + count, pos, [](quint32 p, const Node &n) {
+        return p < n.foldOff;
+    });
+    return quint32(it - nodes) - 1;
+}
+
+PathIndex::PathIndex(QObject *parent) : QObject(parent)
+{
+}
+
+QString PathIndex::defaultPath()
+{
+    auto dir = QDir(QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation));
+    return dir.absoluteFilePath("pathindex.bin");
+}
+
+static bool isSkipped(const std::vector<std::string> &skipped, const char *name, int flags = 0)
+{
+    for (const auto &pattern : skipped) {
+        if (fnmatch(pattern.c_str(), name, flags) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PathIndex::build(const QStringList &topdirs, const std::vector<std::string> &skipped,
+                      const std::vector<std::string> &skippedPaths, const QString &path)
+{
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<Node> nodes;
+    std::string names, fold;
+    auto addNode = [&](quint32 parent, const QByteArray &name, bool dir) {
+        nodes.push_back({parent, quint32(names.size()), quint32(fold.size()),
+                         dir ? flagDir : 0});
+        names.append(name.constData(), name.size());
+        fold += QString::fromUtf8(name).toLower().toStdString();
+        fold.push_back('\0');
+        return quint32(nodes.size() - 1);
+    };
+    std::vector<std::pair<QByteArray, quint32>> stack;
+    for (const auto &top : topdirs) {
+        auto local = QFile::encodeName(QDir::cleanPath(top));
+        stack.push_back({local, addNode(noParent, local, true)});
+    }
+    while (!stack.empty()) {
+        auto dirPath = stack.back().first;
+        auto dirNode = stack.back().second;
+        stack.pop_back();
+        auto dir = opendir(dirPath.constData());
+        if (dir == nullptr) {
+            continue;
+        }
+        while (auto ent = readdir(dir)) {
+            auto name = ent->d_name;
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0 || isSkipped(skipped, name)) {
+                continue;
+            }
+            auto full = dirPath + '/' + name;
+            // 和 FsWatcher 一样，skippedPaths 按完整路径匹配
+            if (isSkipped(skippedPaths, full.constData(), FNM_PATHNAME)) {
+                continue;
+            }
+            bool isDir = ent->d_type == DT_DIR;
+            if (ent->d_type == DT_UNKNOWN) {
+                struct stat st;
+                isDir = lstat(full.constData(), &st) == 0 && S_ISDIR(st.st_mode);
+            }
+            auto node = addNode(dirNode, QByteArray(name), isDir);
+            // 符号链接的目录不进去，d_type 是 DT_LNK
+            if (isDir) {
+                stack.push_back({full, node});
+            }
+        }
+        closedir(dir);
+    }
+    // 哨兵，用来算最后一个名字的长度
+    nodes.push_back({noParent, quint32(names.size()), quint32(fold.size()), 0});
+
+    Header header;
+    memcpy(header.magic, pathIndexMagic, sizeof(header.magic));
+    header.version = pathIndexVersion;
+    header.count = nodes.size() - 1;
+    header.namesSize = names.size();
+    header.foldSize = fold.size();
+
+    QFile out(path + ".tmp");
+    if (!out.open(QFile::WriteOnly | QFile::Truncate)) {
+        return false;
+    }
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(nodes.data()), nodes.size() * sizeof(Node));
+    out.write(names.data(), names.size());
+    out.write(fold.data(), fold.size());
+    if (!out.flush()) {
+        out.remove();
+        return false;
+    }
+    out.close();
+    // 改名是原子的，正在查询的线程还在用旧文件的映射
+    if (::rename(QFile::encodeName(out.fileName()).constData(),
+                 QFile::encodeName(path).constData()) != 0) {
+        out.remove();
+        return false;
+    }
+    qDebug() << "PathIndex:" << header.count << "entries," << header.foldSize << "bytes of names in"
+             << timer.elapsed() << "ms";
+    return true;
+}
+
+std::shared_ptr<PathIndex::Snapshot> PathIndex::map(const QString &path)
+{
+    auto snap = std::make_shared<Snapshot>();
+    snap->file.setFileName(path);
+    if (!snap->file.open(QFile::ReadOnly) || snap->file.size() < qint64(sizeof(Header))) {
+        return nullptr;
+    }
+    auto base = snap->file.map(0, snap->file.size());
+    if (base == nullptr) {
+        return nullptr;
+    }
+    snap->base = base;
+    auto header = reinterpret_cast<const Header *>(base);
+    qint64 need = sizeof(Header) + qint64(header->count + 1) * sizeof(Node) +
+                  header->namesSize + header->foldSize;
+    if (memcmp(header->magic, pathIndexMagic, sizeof(header->magic)) != 0 ||
+        header->version != pathIndexVersion || snap->file.size() < need) {
+        qWarning() << "PathIndex: bad index" << path;
+        return nullptr;
+    }
+    snap->count = header->count;
+    snap->foldSize = header->foldSize;
+    snap->nodes = reinterpret_cast<const Node *>(base + sizeof(Header));
+    snap->names = reinterpret_cast<const char *>(snap->nodes + snap->count + 1);
+    snap->fold = snap->names + header->namesSize;
+    return snap;
+}
+
+bool PathIndex::open()
+{
+    auto snap = map(defaultPath());
+    if (!snap) {
+        return false;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_snapshot = snap;
+    return true;
+}
+
+void PathIndex::openOrBuild()
+{
+    auto path = defaultPath();
+    if (!open() || QFileInfo(path).lastModified().secsTo(QDateTime::currentDateTime()) > maxAgeSecs) {
+        rebuild();
+    }
+}
+
+void PathIndex::rebuild()
+{
+    QStringList topdirs;
+    theconfig->setKeyDir("");
+    for (const auto &dir : theconfig->getTopdirs()) {
+        topdirs << QString::fromStdString(dir);
+    }
+    auto skipped = theconfig->getSkippedNames();
+    auto skippedPaths = theconfig->getSkippedPaths();
+    quint64 startSeq;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_building) {
+            return;
+        }
+        m_building = true;
+        startSeq = m_seq;
+    }
+    QtConcurrent::run([this, topdirs, skipped, skippedPaths, startSeq]() {
+        auto path = defaultPath();
+        auto snap = build(topdirs, skipped, skippedPaths, path) ? map(path) : nullptr;
+        QMutexLocker locker(&m_mutex);
+        m_building = false;
+        if (!snap) {
+            return;
+        }
+        m_snapshot = snap;
+        // 开始重建之前的变化已经包含在新的索引里
+        for (auto *set : {&m_added, &m_deleted}) {
+            for (auto it = set->begin(); it != set->end();) {
+                if (it.value() <= startSeq) {
+                    it = set->erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    });
+}
+
+std::shared_ptr<const PathIndex::Snapshot> PathIndex::snapshot() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_snapshot;
+}
+
+void PathIndex::filesChanged(const QStringList &paths)
+{
+    bool full;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const auto &p : paths) {
+            m_deleted.remove(p);
+            m_added.insert(p, ++m_seq);
+        }
+        full = m_added.size() + m_deleted.size() > maxOverlay;
+    }
+    if (full) {
+        rebuild();
+    }
+}
+
+void PathIndex::filesDeleted(const QStringList &paths)
+{
+    bool full;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const auto &p : paths) {
+            m_added.remove(p);
+            m_deleted.insert(p, ++m_seq);
+        }
+        full = m_added.size() + m_deleted.size() > maxOverlay;
+    }
+    if (full) {
+        rebuild();
+    }
+}
+
+std::vector<quint32> PathIndex::scan(const Snapshot &snap, const QByteArray &needle, int maxHits)
+{
+    // 按 \0 切成几段，每段一个线程
+    std::vector<std::pair<quint32, quint32>> chunks;
+    int parts = snap.foldSize < minChunk ? 1 : qMax(1, QThread::idealThreadCount());
+    quint32 begin = 0;
+    for (int i = 1; i <= parts && begin < snap.foldSize; i++) {
+        quint32 end = i == parts ? snap.foldSize : quint32(quint64(snap.foldSize) * i / parts);
+        auto zero = static_cast<const char *>(memchr(snap.fold + end, 0, snap.foldSize - end));
+        end = zero == nullptr ? snap.foldSize : quint32(zero - snap.fold) + 1;
+        chunks.push_back({begin, end});
+        begin = end;
+    }
+    auto scanChunk = [&snap, &needle, maxHits](const std::pair<quint32, quint32> &chunk) {
+        std::vector<quint32> nodes;
+        PathScan::findAll(snap.fold + chunk.first, chunk.second - chunk.first,
+                          needle.constData(), needle.size(), [&](size_t pos) {
+                              auto node = snap.nodeAt(quint32(chunk.first + pos));
+                              // 一个名字里出现多次只算一次
+                              if (nodes.empty() || nodes.back() != node) {
+                                  nodes.push_back(node);
+                              }
+                              return int(nodes.size()) < maxHits;
+                          });
+        return nodes;
+    };
+    std::vector<quint32> out;
+    if (chunks.size() == 1) {
+        return scanChunk(chunks[0]);
+    }
+    QList<QFuture<std::vector<quint32>>> futures;
+    for (const auto &chunk : chunks) {
+        futures << QtConcurrent::run([&scanChunk, chunk]() { return scanChunk(chunk); });
+    }
+    for (auto &f : futures) {
+        auto nodes = f.result();
+        out.insert(out.end(), nodes.begin(), nodes.end());
+    }
+    return out;
+}
+
+int PathIndex::score(const QString &lowerName, const QString &whole, bool dir)
+{
+    int s = lowerName.startsWith(whole) ? 75 : lowerName.contains(whole) ? 65 : 55;
+    // 名字越短越接近输入的内容
+    s -= qMin(10, lowerName.size() / 8);
+    return dir ? s - 5 : s;
+}
+
+std::vector<Rcl::Doc> PathIndex::query(const QString &text, int budgetMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<Rcl::Doc> docs;
+    auto words = text.toLower().split(' ', QString::SkipEmptyParts);
+    if (words.isEmpty()) {
+        return docs;
+    }
+    auto whole = words.join(' ');
+    // 最长的词用来扫描，其它的词再检查
+    auto needle = *std::max_element(words.begin(), words.end(),
+                                    [](const QString &a, const QString &b) {
+                                        return a.size() < b.size();
+                                    });
+    auto snap = snapshot();
+    QStringList added;
+    QHash<QString, quint64> deleted;
+    {
+        QMutexLocker locker(&m_mutex);
+        added = m_added.keys();
+        deleted = m_deleted;
+    }
+    auto isDeleted = [&deleted](const QString &path) {
+        for (int i = path.size(); i > 0; i = path.lastIndexOf('/', i - 1)) {
+            if (deleted.contains(path.left(i))) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto matchesAll = [&words](const QString &lowerName) {
+        return std::all_of(words.begin(), words.end(),
+                           [&lowerName](const QString &w) { return lowerName.contains(w); });
+    };
+    std::vector<Hit> hits;
+    QSet<QString> seen;
+    if (snap) {
+        QueryTrace::Span span("path scan");
+        auto nodes = scan(*snap, needle.toUtf8(), maxCandidates);
+        span.setArg("candidates", int(nodes.size()));
+        span.setArg("kernel", PathScan::kernelName());
+        for (auto node : nodes) {
+            if (timer.elapsed() > budgetMs) {
+                break;
+            }
+            auto lowerName = QString::fromUtf8(snap->foldName(node));
+            if (!matchesAll(lowerName)) {
+                continue;
+            }
+            auto path = snap->path(node);
+            if (!deleted.isEmpty() && isDeleted(path)) {
+                continue;
+            }
+            bool dir = snap->nodes[node].flags & flagDir;
+            seen.insert(path);
+            hits.push_back({path, dir, score(lowerName, whole, dir)});
+        }
+    }
+    for (const auto &path : added) {
+        auto lowerName = QFileInfo(path).fileName().toLower();
+        if (seen.contains(path) || !matchesAll(lowerName)) {
+            continue;
+        }
+        bool dir = QFileInfo(path).isDir();
+        hits.push_back({path, dir, score(lowerName, whole, dir)});
+    }
+    auto keep = std::min(int(hits.size()), maxResults);
+    std::partial_sort(hits.begin(), hits.begin() + keep, hits.end(),
+                      [](const Hit &a, const Hit &b) {
+                          return a.score != b.score ? a.score > b.score
+                                                    : a.path.size() < b.path.size();
+                      });
+    QMimeDatabase mimes;
+    for (int i = 0; i < keep; i++) {
+        const auto &hit = hits[i];
+        QFileInfo info(hit.path);
+        auto mime = hit.dir ? QString("inode/directory")
+                            : mimes.mimeTypeForFile(hit.path, QMimeDatabase::MatchExtension).name();
+        auto doc = makeDoc("file://" + hit.path, mime, info.fileName(), info.path(), hit.score);
+        doc.meta[DocSeqRanked::groupField] = "filename";
+        docs.push_back(std::move(doc));
+    }
+    return docs;
+}
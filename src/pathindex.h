@@ -0,0 +1,100 @@
+#ifndef PATHINDEX_H
+#define PATHINDEX_H
+
+#include "searchprovider.h"
+
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * 类似 Everything 的文件名索引，覆盖 topdirs 下的所有文件。
+ * 每个目录只保存一次，文件和目录都只记自己的名字和父节点，完整路径沿父节点拼出来。
+ * 小写的文件名连续存放在一块缓冲区里（以 \0 分隔），查询时分成几段在多个线程里
+ * 用 PathScan 的 SIMD 子串查找扫描，能找到词中间的子串。
+ * 索引文件 mmap 进来；文件变化先记在内存里的增删表中，表太大时在后台重建。
+ */
+class PathIndex : public QObject, public SearchProvider
+{
+    Q_OBJECT
+public:
+    explicit PathIndex(QObject *parent = nullptr);
+
+    QString name() const override { return "files"; }
+    std::vector<Rcl::Doc> query(const QString &text, int budgetMs) override;
+
+    static QString defaultPath();
+    // 只打开已有的文件，不重建，给命令行用
+    bool open();
+    // 文件不存在或者太旧时重建
+    void openOrBuild();
+    // 在后台线程里重新扫描 topdirs
+    void rebuild();
+
+public slots:
+    void filesChanged(const QStringList &paths);
+    void filesDeleted(const QStringList &paths);
+
+private:
+    struct Header {
+        char magic[4];
+        quint32 version;
+        quint32 count;
+        quint32 namesSize;
+        quint32 foldSize;
+    };
+    struct Node {
+        // 父节点，topdir 本身是 noParent，名字是完整路径
+        quint32 parent;
+        quint32 nameOff;
+        quint32 foldOff;
+        quint32 flags;
+    };
+    // 映射进来的一个索引文件，最后有一个哨兵节点
+    struct Snapshot {
+        ~Snapshot();
+        QFile file;
+        uchar *base{nullptr};
+        const Node *nodes{nullptr};
+        const char *names{nullptr};
+        const char *fold{nullptr};
+        quint32 count{0};
+        quint32 foldSize{0};
+
+        QString path(quint32 node) const;
+        QByteArray foldName(quint32 node) const;
+        // fold 中 pos 位置属于哪个节点
+        quint32 nodeAt(quint32 pos) const;
+    };
+    struct Hit {
+        QString path;
+        bool dir;
+        int score;
+    };
+
+    static bool build(const QStringList &topdirs, const std::vector<std::string> &skipped,
+                      const std::vector<std::string> &skippedPaths, const QString &path);
+    static std::shared_ptr<Snapshot> map(const QString &path);
+    std::shared_ptr<const Snapshot> snapshot() const;
+    // 在 PathScan 中找 needle，返回候选节点
+    static std::vector<quint32> scan(const Snapshot &snap, const QByteArray &needle,
+                                     int maxHits);
+    static int score(const QString &lowerName, const QString &whole, bool dir);
+
+private:
+    mutable QMutex m_mutex;
+    std::shared_ptr<const Snapshot> m_snapshot;
+    bool m_building{false};
+    // 索引文件之后的变化：路径 -> 序号，重建完成后去掉开始重建前的部分
+    QHash<QString, quint64> m_added;
+    QHash<QString, quint64> m_deleted;
+    quint64 m_seq{0};
+};
+
+#endif // PATHINDEX_H
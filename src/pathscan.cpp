@@ -0,0 +1,128 @@
+#include "pathscan.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PATHSCAN_X86 1
+#endif
+
+namespace {
+
+typedef void (*Kernel)(const char *, size_t, const char *, size_t,
+                       const std::function<bool(size_t)> &);
+
+void scalarKernel(const char *hay, size_t len, const char *needle, size_t nlen,
+                  const std::function<bool(size_t)> &onMatch)
+{
+    auto p = hay, end = hay + len;
+    while (p + nlen <= end) {
+        auto found = static_cast<const char *>(memmem(p, end - p, needle, nlen));
+        if (found == nullptr || !onMatch(found - hay)) {
+            return;
+        }
+        p = found + 1;
+    }
+}
+
+#ifdef PATHSCAN_X86
+// 首尾字节已经相等，比较中间的字节
+inline bool middleEqual(const char *p, const char *needle, size_t nlen)
+{
+    return nlen <= 2 || memcmp(p + 1, needle + 1, nlen - 2) == 0;
+}
+
+__attribute__((target("avx2")))
+void avx2Kernel(const char *hay, size_t len, const char *needle, size_t nlen,
+                const std::function<bool(size_t)> &onMatch)
+{
+    const auto first = _mm256_set1_epi8(needle[0]);
+    const auto last = _mm256_set1_epi8(needle[nlen - 1]);
+    size_t i = 0;
+    for (; i + nlen - 1 + 32 <= len; i += 32) {
+        auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(hay + i));
+        auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(hay + i + nlen - 1));
+        auto mask = uint32_t(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+        while (mask != 0) {
+            auto bit = __builtin_ctz(mask);
+            if (middleEqual(hay + i + bit, needle, nlen) && !onMatch(i + bit)) {
+                return;
+            }
+            mask &= mask - 1;
+        }
+    }
+    if (i < len) {
+        scalarKernel(hay + i, len - i, needle, nlen, [i, &onMatch](size_t pos) {
+            return onMatch(i + pos);
+        });
+    }
+}
+
+void sse2Kernel(const char *hay, size_t len, const char *needle, size_t nlen,
+                const std::function<bool(size_t)> &onMatch)
+{
+    const auto first = _mm_set1_epi8(needle[0]);
+    const auto last = _mm_set1_epi8(needle[nlen - 1]);
+    size_t i = 0;
+    for (; i + nlen - 1 + 16 <= len; i += 16) {
+        auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hay + i));
+        auto b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hay + i + nlen - 1));
+        auto mask = uint32_t(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+        while (mask != 0) {
+            auto bit = __builtin_ctz(mask);
+            if (middleEqual(hay + i + bit, needle, nlen) && !onMatch(i + bit)) {
+                return;
+            }
+            mask &= mask - 1;
+        }
+    }
+    if (i < len) {
+        scalarKernel(hay + i, len - i, needle, nlen, [i, &onMatch](size_t pos) {
+            return onMatch(i + pos);
+        });
+    }
+}
+#endif
+
+struct Dispatch {
+    Kernel kernel;
+    const char *name;
+};
+
+Dispatch choose()
+{
+#ifdef PATHSCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {avx2Kernel, "avx2"};
+    }
+    return {sse2Kernel, "sse2"};
+#else
+    return {scalarKernel, "scalar"};
+#endif
+}
+
+const Dispatch &dispatch()
+{
+    static const Dispatch d = choose();
+    return d;
+}
+
+}
+
+void PathScan::findAll(const char *hay, size_t len, const char *needle, size_t nlen,
+                       const std::function<bool(size_t)> &onMatch)
+{
+    if (nlen == 0 || nlen > len) {
+        return;
+    }
+    dispatch().kernel(hay, len, needle, nlen, onMatch);
+}
+
+const char *PathScan::kernelName()
+{
+    return dispatch().name;
+}
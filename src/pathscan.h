@@ -0,0 +1,23 @@
+#ifndef PATHSCAN_H
+#define PATHSCAN_H
+
+#include <cstddef>
+#include <functional>
+
+/*
+ * 在一大块文字里找子串的所有位置，给 PathIndex 扫描文件名用。
+ * x86_64 上按 CPU 支持选择 AVX2 或 SSE2 的实现：一次比较 32/16 个位置上
+ * 子串的首字节和尾字节，两者都相等的位置再用 memcmp 确认。其它平台用 memmem。
+ */
+namespace PathScan {
+
+// 每找到一个位置调用一次 onMatch，返回 false 时停止
+void findAll(const char *hay, size_t len, const char *needle, size_t nlen,
+             const std::function<bool(size_t)> &onMatch);
+
+// 当前使用的实现："avx2"、"sse2" 或 "scalar"
+const char *kernelName();
+
+}
+
+#endif // PATHSCAN_H
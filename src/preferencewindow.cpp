@@ -1,22 +1,31 @@
 #include "preferencewindow.h"
 #include "config.h"
+#include "globalshortcut.h"
 #include "indexsche.h"
+#include "indexscheduler.h"
 
 #include <QFormLayout>
 #include <QGroupBox>
+#include <QMessageBox>
 #include <QVBoxLayout>
 #include <QDebug>
 
-PreferenceWindow::PreferenceWindow(QWidget *parent) : QDialog(parent) {
+PreferenceWindow::PreferenceWindow(QWidget *parent, IndexProgressMonitor *monitor)
+    : QDialog(parent), progressMonitor(monitor) {
 //    this->setAttribute(Qt::WA_DeleteOnClose);
   this->msetting = new QSettings(ORGANIZATION_NAME, AppName, parent);
   this->tabWidget = new QTabWidget(this);
   this->tabGeneral = new QWidget(this);
   this->tabIndex = new QWidget(this);
   this->tabIndexSche = new QWidget(this);
+  this->tabIndexStatus = new QWidget(this);
   this->ckb_show_indicator = new QCheckBox(this);
+  this->general_hotkey = new QKeySequenceEdit(GlobalShortcut::instance()->shortcut(), this);
   this->general_index_update = new QPushButton(this->tr("Update Index"));
   this->general_index_reindex = new QPushButton(this->tr("Reindex"));
+  this->status_progress = new QLabel(this);
+  this->status_counts = new QLabel(this);
+  this->status_filters = new QLabel(this);
   this->btnBox =
       new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
     init_ui();
@@ -36,6 +45,8 @@ void PreferenceWindow::init_ui() {
 
   general_left_formlayout->addRow(this->tr("Show Indicator"),
                                   this->ckb_show_indicator);
+  general_left_formlayout->addRow(this->tr("Show Window Hotkey"),
+                                  this->general_hotkey);
 
   auto general_group_index = new QGroupBox(this->tr("Index"));
   vmlayout->addWidget(general_group_index);
@@ -46,6 +57,13 @@ void PreferenceWindow::init_ui() {
   general_index_formlayout->addWidget(this->general_index_update);
   general_index_formlayout->addWidget(this->general_index_reindex);
 
+  auto status_formlayout = new QFormLayout();
+  this->tabIndexStatus->setLayout(status_formlayout);
+  status_formlayout->addRow(this->tr("Progress"), this->status_progress);
+  status_formlayout->addRow(this->tr("Files"), this->status_counts);
+  // 最慢的几个过滤器
+  status_formlayout->addRow(this->tr("Filter time"), this->status_filters);
+
   auto index_vlayout = new QVBoxLayout();
   this->tabIndex->setLayout(index_vlayout);
 
@@ -63,6 +81,7 @@ void PreferenceWindow::init_ui() {
   this->tabWidget->addTab(this->tabGeneral, this->tr("General"));
   this->tabWidget->addTab(this->tabIndex, this->tr("Global Index"));
   this->tabWidget->addTab(this->tabIndexSche, this->tr("Sched"));
+  this->tabWidget->addTab(this->tabIndexStatus, this->tr("Index Status"));
 
   auto main_layout = new QVBoxLayout();
   main_layout->addWidget(this->tabWidget);
@@ -72,14 +91,51 @@ void PreferenceWindow::init_ui() {
 
 void PreferenceWindow::init_conn()
 {
+    connect(this->general_index_update,&QPushButton::clicked,[](){
+        IndexScheduler::instance()->runNow(false);
+    });
+    connect(this->general_index_reindex,&QPushButton::clicked,[](){
+        IndexScheduler::instance()->runNow(true);
+    });
+    if (this->progressMonitor != nullptr) {
+        connect(this->progressMonitor, &IndexProgressMonitor::progressChanged,
+                this, &PreferenceWindow::show_progress);
+        show_progress(this->progressMonitor->current());
+    }
 
     connect(this->btnBox,&QDialogButtonBox::accepted,[this](){
         qDebug()<<"accepted";
         this->topDir->save_config();
         this->skipDir->save_config();
+        // 清空快捷键表示不绑定，setShortcut 会成功
+        auto seq = this->general_hotkey->keySequence();
+        if (seq != GlobalShortcut::instance()->shortcut() &&
+            !GlobalShortcut::instance()->setShortcut(seq)) {
+            QMessageBox::warning(this, this->tr("Hotkey"),
+                                 this->tr("%1 is already in use.").arg(seq.toString()));
+            return;
+        }
         this->close();
     });
     connect(this->btnBox,&QDialogButtonBox::rejected,[this](){
         this->close();
     });
 }
+
+void PreferenceWindow::showIndexStatus()
+{
+    this->tabWidget->setCurrentWidget(this->tabIndexStatus);
+}
+
+void PreferenceWindow::show_progress(const IndexProgress &progress)
+{
+    this->status_progress->setText(progress.summary());
+    QString counts;
+    if (progress.source != IndexProgress::SRC_NONE) {
+        counts = this->tr("%1 indexed, %2 unchanged or skipped, %3 errors, %4 KB")
+                .arg(progress.filesIndexed).arg(progress.filesWithoutDocs)
+                .arg(progress.fileErrors).arg(progress.bytesProcessed / 1024);
+    }
+    this->status_counts->setText(counts);
+    this->status_filters->setText(progress.filterReport());
+}
@@ -2,10 +2,13 @@
 #define PREFERENCEWINDOW_H
 
 #include "configlistwidget.h"
+#include "indexprogress.h"
 
 #include <QCheckBox>
 #include <QDialog>
 #include <QDialogButtonBox>
+#include <QKeySequenceEdit>
+#include <QLabel>
 #include <QObject>
 #include <QPushButton>
 #include <QSettings>
@@ -14,7 +17,9 @@
 class PreferenceWindow : public QDialog
 {
 public:
-    PreferenceWindow(QWidget *parent);
+    PreferenceWindow(QWidget *parent, IndexProgressMonitor *monitor = nullptr);
+    // 打开时直接显示索引状态页（托盘菜单里的"索引状态"）
+    void showIndexStatus();
 
 
 private:
@@ -23,19 +28,26 @@ private:
     QWidget	*tabGeneral;
     QWidget *tabIndex;
     QWidget *tabIndexSche;
+    QWidget *tabIndexStatus;
     QPushButton *general_index_update;
     QPushButton *general_index_reindex;
+    QLabel *status_progress;
+    QLabel *status_counts;
+    QLabel *status_filters;
+    IndexProgressMonitor *progressMonitor;
     ConfigListWidget *topDir;
     ConfigListWidget *skipDir;
 
 //    QCheckBox *ckb_show_window_on_start=QCheckBox
     QCheckBox *ckb_show_indicator;
+    QKeySequenceEdit *general_hotkey;
     QDialogButtonBox *btnBox;
 
 private:
     void init_ui();
     void init_conn();
     void read_settings();
+    void show_progress(const IndexProgress &progress);
 
 
 
@@ -0,0 +1,277 @@
+#include "querycompiler.h"
+#include "querytrace.h"
+
+#include <QStringList>
+
+#include <guiutils.h>
+#include <log.h>
+#include <textsplit.h>
+
+// 前缀扩展最多展开的词数
+static const int maxPrefixExpansion = 200;
+// 扩展名最长的长度
+static const int maxExtLength = 6;
+
+namespace {
+class WordCollector : public TextSplit
+{
+public:
+    WordCollector() : TextSplit(TXTS_NOSPANS) {
+    }
+
+    bool takeword(const std::string &term, int, int, int) override {
+        words.push_back(term);
+        return true;
+    }
+
+    std::vector<std::string> words;
+};
+}
+
+static bool isCJK(QChar c)
+{
+    switch (c.script()) {
+    case QChar::Script_Han:
+    case QChar::Script_Hiragana:
+    case QChar::Script_Katakana:
+    case QChar::Script_Hangul:
+    case QChar::Script_Bopomofo:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool isExt(const QString &s)
+{
+    if (s.isEmpty() || s.size() > maxExtLength) {
+        return false;
+    }
+    for (auto c : s) {
+        if (!c.isLetterOrNumber()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 普通文字用 TextSplit 切分，和建索引时的规则一致
+static void splitWords(const QString &chunk, QVector<QueryCompiler::Token> &out)
+{
+    WordCollector wc;
+    wc.text_to_words(chunk.toStdString());
+    for (const auto &w : wc.words) {
+        out.append({QString::fromStdString(w), QueryCompiler::TK_WORD});
+    }
+}
+
+// 一段文字中 CJK 和其它文字分开
+static void splitScripts(const QString &chunk, QVector<QueryCompiler::Token> &out)
+{
+    int start = 0;
+    while (start < chunk.size()) {
+        bool cjk = isCJK(chunk[start]);
+        int end = start + 1;
+        while (end < chunk.size() && isCJK(chunk[end]) == cjk) {
+            end++;
+        }
+        auto run = chunk.mid(start, end - start);
+        if (cjk) {
+            out.append({run, QueryCompiler::TK_CJK});
+        } else {
+            splitWords(run, out);
+        }
+        start = end;
+    }
+}
+
+QVector<QueryCompiler::Token> QueryCompiler::tokenize(const QString &text)
+{
+    QVector<Token> out;
+    auto chunks = text.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+    for (const auto &chunk : chunks) {
+        if (chunk.startsWith('/') || chunk.startsWith('~')) {
+            out.append({chunk, TK_PATH});
+            continue;
+        }
+        if (chunk.startsWith("*.") && isExt(chunk.mid(2))) {
+            out.append({chunk.mid(2).toLower(), TK_EXT});
+            continue;
+        }
+        if (chunk.startsWith('.') && isExt(chunk.mid(1))) {
+            out.append({chunk.mid(1).toLower(), TK_EXT});
+            continue;
+        }
+        // report.pdf：文件名加扩展名，node.js、example.com 也是这种形式
+        auto dot = chunk.lastIndexOf('.');
+        if (dot > 0 && isExt(chunk.mid(dot + 1)) && !chunk[dot + 1].isDigit()) {
+            out.append({chunk, TK_NAMEEXT});
+            continue;
+        }
+        splitScripts(chunk, out);
+    }
+    // 用户还在输入最后一个词（后面没有空格）
+    if (!out.isEmpty() && !text.isEmpty() && !text[text.size() - 1].isSpace()) {
+        if (out.last().kind == TK_WORD) {
+            out.last().kind = TK_PREFIX;
+        } else if (out.last().kind == TK_NAMEEXT) {
+            out.last().kind = TK_NAMEEXTPREFIX;
+        }
+    }
+    return out;
+}
+
+std::string QueryCompiler::stemLang(const RclConfig *config)
+{
+    if (config == nullptr) {
+        return prefs.stemlang();
+    }
+    // 和 PrefsPack::stemlang 相同，只是 ALL 时读 config
+    auto lang = prefs.queryStemLang.toStdString();
+    if (lang == "ALL") {
+        lang.clear();
+        config->getConfParam("indexstemminglanguages", lang);
+    }
+    return lang;
+}
+
+std::shared_ptr<Rcl::SearchData> QueryCompiler::compile(const QString &text, const RclConfig *config)
+{
+    QueryTrace::Span span("parse");
+    auto tokens = tokenize(text);
+    span.setArg("tokens", describe(tokens));
+    return compile(tokens, config);
+}
+
+// field 为空时在全文中找，路径和扩展名不受 field 影响
+static Rcl::SearchDataClause *makeClause(const QueryCompiler::Token &tok,
+                                         Rcl::SClType tp, const std::string &field,
+                                         const std::string &lang)
+{
+    auto u8 = tok.text.toStdString();
+    switch (tok.kind) {
+    case QueryCompiler::TK_WORD:
+        return new Rcl::SearchDataClauseSimple(tp, u8, field);
+    case QueryCompiler::TK_PREFIX:
+        return new Rcl::SearchDataClauseSimple(tp, u8 + "*", field);
+    case QueryCompiler::TK_PATH:
+        return new Rcl::SearchDataClausePath(u8, false);
+    case QueryCompiler::TK_EXT:
+        return new Rcl::SearchDataClauseSimple(tp, u8, "ext");
+    case QueryCompiler::TK_CJK:
+        // 索引时 CJK 按字切成 n-gram，短语保证它们相邻
+        return new Rcl::SearchDataClauseDist(Rcl::SCLT_PHRASE, u8, 0, field);
+    case QueryCompiler::TK_NAMEEXT:
+    case QueryCompiler::TK_NAMEEXTPREFIX: {
+        // (名字的各个词 AND ext:扩展名) OR 整个词组成的短语
+        bool prefix = tok.kind == QueryCompiler::TK_NAMEEXTPREFIX;
+        auto dot = tok.text.lastIndexOf('.');
+        QVector<QueryCompiler::Token> parts;
+        splitScripts(tok.text.left(dot), parts);
+        // 正在输入时 report.p 也要找到 reports.pdf
+        if (prefix && !parts.isEmpty() && parts.last().kind == QueryCompiler::TK_WORD) {
+            parts.last().kind = QueryCompiler::TK_PREFIX;
+        }
+        auto named = std::make_shared<Rcl::SearchData>(Rcl::SCLT_AND, lang);
+        named->setMaxExpand(maxPrefixExpansion);
+        for (const auto &part : parts) {
+            named->addClause(makeClause(part, Rcl::SCLT_AND, field, lang));
+        }
+        auto ext = tok.text.mid(dot + 1).toLower().toStdString();
+        named->addClause(new Rcl::SearchDataClauseSimple(Rcl::SCLT_AND, prefix ? ext + "*" : ext,
+                                                         "ext"));
+        auto either = std::make_shared<Rcl::SearchData>(Rcl::SCLT_OR, lang);
+        either->setMaxExpand(maxPrefixExpansion);
+        either->addClause(new Rcl::SearchDataClauseSub(named));
+        // 短语里的通配符由 recoll 展开
+        either->addClause(new Rcl::SearchDataClauseDist(Rcl::SCLT_PHRASE,
+                                                        prefix ? u8 + "*" : u8, 0, field));
+        return new Rcl::SearchDataClauseSub(either);
+    }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<Rcl::SearchData> QueryCompiler::compile(const QVector<Token> &tokens, const RclConfig *config)
+{
+    if (tokens.isEmpty()) {
+        return std::shared_ptr<Rcl::SearchData>();
+    }
+    auto lang = stemLang(config);
+    auto sdata = std::make_shared<Rcl::SearchData>(Rcl::SCLT_AND, lang);
+    sdata->setMaxExpand(maxPrefixExpansion);
+    for (const auto &tok : tokens) {
+        sdata->addClause(makeClause(tok, Rcl::SCLT_AND, "", lang));
+    }
+    LOGDEB("QueryCompiler::compile: " << describe(tokens).toStdString() << "\n");
+    return sdata;
+}
+
+std::shared_ptr<Rcl::SearchData> QueryCompiler::compile(const QVector<Token> &tokens,
+                                                       const QVector<QStringList> &alternatives,
+                                                       const RclConfig *config)
+{
+    if (tokens.isEmpty()) {
+        return std::shared_ptr<Rcl::SearchData>();
+    }
+    auto lang = stemLang(config);
+    auto sdata = std::make_shared<Rcl::SearchData>(Rcl::SCLT_AND, lang);
+    sdata->setMaxExpand(maxPrefixExpansion);
+    for (int i = 0; i < tokens.size(); i++) {
+        const auto &tok = tokens[i];
+        auto alts = i < alternatives.size() ? alternatives[i] : QStringList();
+        if (alts.isEmpty() || (tok.kind != TK_WORD && tok.kind != TK_PREFIX)) {
+            sdata->addClause(makeClause(tok, Rcl::SCLT_AND, "", lang));
+            continue;
+        }
+        // 词 OR 近似词...，正在输入的词保留前缀扩展
+        auto sub = std::make_shared<Rcl::SearchData>(Rcl::SCLT_OR, lang);
+        sub->setMaxExpand(maxPrefixExpansion);
+        sub->addClause(makeClause(tok, Rcl::SCLT_OR, "", lang));
+        for (const auto &alt : alts) {
+            sub->addClause(makeClause({alt, TK_WORD}, Rcl::SCLT_OR, "", lang));
+        }
+        sdata->addClause(new Rcl::SearchDataClauseSub(sub));
+    }
+    return sdata;
+}
+
+std::shared_ptr<Rcl::SearchData> QueryCompiler::compileNames(const QString &text, const RclConfig *config)
+{
+    // 程序由 AppIndex 在内存里查找，不在 recoll 的索引中
+    static const char *nameFields[] = {"filename", "title"};
+    auto tokens = tokenize(text);
+    auto lang = stemLang(config);
+    auto sdata = std::make_shared<Rcl::SearchData>(Rcl::SCLT_AND, lang);
+    sdata->setMaxExpand(maxPrefixExpansion);
+    bool hasNameTerm = false;
+    for (const auto &tok : tokens) {
+        if (tok.kind == TK_PATH || tok.kind == TK_EXT) {
+            sdata->addClause(makeClause(tok, Rcl::SCLT_AND, "", lang));
+            continue;
+        }
+        // 每个词：filename:词 OR title:词
+        auto sub = std::make_shared<Rcl::SearchData>(Rcl::SCLT_OR, lang);
+        sub->setMaxExpand(maxPrefixExpansion);
+        for (auto field : nameFields) {
+            sub->addClause(makeClause(tok, Rcl::SCLT_OR, field, lang));
+        }
+        sdata->addClause(new Rcl::SearchDataClauseSub(sub));
+        hasNameTerm = true;
+    }
+    if (!hasNameTerm) {
+        return std::shared_ptr<Rcl::SearchData>();
+    }
+    return sdata;
+}
+
+QString QueryCompiler::describe(const QVector<Token> &tokens)
+{
+    static const char *names[] = {"word", "prefix", "path", "ext", "cjk", "nameext",
+                                  "nameextprefix"};
+    QStringList parts;
+    for (const auto &tok : tokens) {
+        parts << QString("%1(%2)").arg(names[tok.kind]).arg(tok.text);
+    }
+    return parts.join(' ');
+}
@@ -0,0 +1,65 @@
+#ifndef QUERYCOMPILER_H
+#define QUERYCOMPILER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <memory>
+#include <string>
+
+#include <rclconfig.h>
+#include <searchdata.h>
+
+/*
+ * 把搜索框里的文字编译成 Rcl::SearchData。
+ * 先按空白切开，再对每一段分类：路径片段、扩展名、中日韩文字、普通词，
+ * 普通词再用 recoll 的 TextSplit 切分。只有最后一个词做前缀扩展（正在输入），
+ * 扩展的数量有上限，词干语言来自 recoll 的界面设置。
+ */
+class QueryCompiler
+{
+public:
+    enum Kind {
+        // 完整的词
+        TK_WORD,
+        // 最后一个还没输完的词，按前缀扩展，通常是程序名的开头
+        TK_PREFIX,
+        // 以 / 或 ~ 开头，限制目录
+        TK_PATH,
+        // .pdf 或 *.pdf
+        TK_EXT,
+        // 中日韩文字，按短语匹配
+        TK_CJK,
+        // report.pdf 或 node.js：可能是文件名加扩展名，也可能就是一个带点的词，
+        // 两种都找
+        TK_NAMEEXT,
+        // 最后一个还没输完的 TK_NAMEEXT，比如 report.p，名字和扩展名都按前缀扩展
+        TK_NAMEEXTPREFIX,
+    };
+    struct Token {
+        QString text;
+        Kind kind;
+    };
+
+    static QVector<Token> tokenize(const QString &text);
+    // config 为空时用全局的 theconfig，其它线程里查询时传入自己的副本
+    static std::shared_ptr<Rcl::SearchData> compile(const QString &text,
+                                                    const RclConfig *config = nullptr);
+    static std::shared_ptr<Rcl::SearchData> compile(const QVector<Token> &tokens,
+                                                    const RclConfig *config = nullptr);
+    // 容错查询：alternatives[i] 是第 i 个词的近似词，和这个词本身 OR 在一起。
+    // 只对 TK_WORD 和 TK_PREFIX 有效，其它种类的词照常编译
+    static std::shared_ptr<Rcl::SearchData> compile(const QVector<Token> &tokens,
+                                                    const QVector<QStringList> &alternatives,
+                                                    const RclConfig *config = nullptr);
+    // 两阶段查询的第一阶段：词只在文件名和标题里找。
+    // 没有可以这样找的词（只有路径或扩展名）时返回空
+    static std::shared_ptr<Rcl::SearchData> compileNames(const QString &text,
+                                                         const RclConfig *config = nullptr);
+    static std::string stemLang(const RclConfig *config = nullptr);
+    // 调试用，类似 "word(fire) prefix(fo)"
+    static QString describe(const QVector<Token> &tokens);
+};
+
+#endif // QUERYCOMPILER_H
@@ -0,0 +1,195 @@
+#include "querytrace.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSocketNotifier>
+#include <QThread>
+
+#include <cstring>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// 大约能放下最近一两百次按键
+static const int ringSize = 4096;
+
+QElapsedTimer QueryTrace::s_clock;
+QMutex QueryTrace::s_mutex;
+QVector<QueryTrace::Event> QueryTrace::s_ring;
+int QueryTrace::s_next = 0;
+bool QueryTrace::s_wrapped = false;
+std::atomic<quint64> QueryTrace::s_current{0};
+qint64 QueryTrace::s_queryStart = 0;
+QString QueryTrace::s_queryText;
+QHash<QString, QPair<qint64, int>> QueryTrace::s_accumulated;
+
+static int signalFds[2] = {-1, -1};
+
+static quint64 currentTid()
+{
+    return quint64(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+}
+
+qint64 QueryTrace::nowUs()
+{
+    // 第一次调用时开始计时，不需要专门初始化
+    static bool started = (s_clock.start(), true);
+    Q_UNUSED(started);
+    return s_clock.nsecsElapsed() / 1000;
+}
+
+QueryTrace::Span::Span(const char *name)
+    : m_name(name), m_query(QueryTrace::currentQuery()), m_start(QueryTrace::nowUs())
+{
+}
+
+QueryTrace::Span::~Span()
+{
+    QueryTrace::record(m_name, m_start, QueryTrace::nowUs() - m_start, m_args, m_query);
+}
+
+void QueryTrace::record(const QString &name, qint64 startUs, qint64 durUs,
+                        const QVariantMap &args, quint64 query)
+{
+    QMutexLocker locker(&s_mutex);
+    if (s_ring.isEmpty()) {
+        s_ring.resize(ringSize);
+    }
+    s_ring[s_next] = {query == 0 ? quint64(s_current) : query, name, startUs, durUs,
+                      currentTid(), args};
+    s_next = (s_next + 1) % ringSize;
+    if (s_next == 0) {
+        s_wrapped = true;
+    }
+}
+
+quint64 QueryTrace::beginQuery(const QString &text)
+{
+    endQuery();
+    QMutexLocker locker(&s_mutex);
+    s_queryStart = nowUs();
+    s_queryText = text;
+    return ++s_current;
+}
+
+void QueryTrace::endQuery()
+{
+    QHash<QString, QPair<qint64, int>> accumulated;
+    QVariantMap args;
+    qint64 start;
+    {
+        QMutexLocker locker(&s_mutex);
+        if (s_current == 0 || s_queryStart < 0) {
+            return;
+        }
+        accumulated.swap(s_accumulated);
+        args["text"] = s_queryText;
+        start = s_queryStart;
+        s_queryStart = -1;
+    }
+    auto now = nowUs();
+    for (auto it = accumulated.constBegin(); it != accumulated.constEnd(); ++it) {
+        QVariantMap accArgs;
+        accArgs["calls"] = it.value().second;
+        record(it.key(), now - it.value().first, it.value().first, accArgs);
+    }
+    record("query", start, now - start, args);
+}
+
+void QueryTrace::accumulate(const char *name, qint64 durUs)
+{
+    QMutexLocker locker(&s_mutex);
+    auto &acc = s_accumulated[QString::fromLatin1(name)];
+    acc.first += durUs;
+    acc.second++;
+}
+
+QByteArray QueryTrace::chromeJson()
+{
+    QVector<Event> events;
+    {
+        QMutexLocker locker(&s_mutex);
+        if (s_wrapped) {
+            events << s_ring.mid(s_next) << s_ring.mid(0, s_next);
+        } else {
+            events = s_ring.mid(0, s_next);
+        }
+    }
+    QJsonArray array;
+    auto pid = qint64(getpid());
+    for (const auto &e : events) {
+        QJsonObject obj;
+        obj["name"] = e.name;
+        obj["cat"] = "query";
+        obj["ph"] = "X";
+        obj["ts"] = e.startUs;
+        obj["dur"] = e.durUs;
+        obj["pid"] = pid;
+        obj["tid"] = qint64(e.tid);
+        auto args = QJsonObject::fromVariantMap(e.args);
+        args["query"] = qint64(e.query);
+        obj["args"] = args;
+        array.append(obj);
+    }
+    QJsonObject root;
+    root["traceEvents"] = array;
+    root["displayTimeUnit"] = "ms";
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+QString QueryTrace::dump(const QString &path)
+{
+    auto out = path;
+    if (out.isEmpty()) {
+        out = QDir::temp().absoluteFilePath(
+            QString("everylauncher-trace-%1.json").arg(getpid()));
+    }
+    QFile file(out);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        qWarning() << "QueryTrace: cannot write" << out;
+        return QString();
+    }
+    file.write(chromeJson());
+    qDebug() << "QueryTrace: dumped to" << out;
+    return out;
+}
+
+static void onSigusr1(int)
+{
+    char c = 1;
+    // 信号处理函数里只能做这种事，剩下的交给事件循环
+    auto ret = ::write(signalFds[0], &c, sizeof(c));
+    Q_UNUSED(ret);
+}
+
+void QueryTrace::installSignalHandler()
+{
+    if (signalFds[1] < 0) {
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, signalFds) != 0) {
+            qWarning() << "QueryTrace: socketpair failed";
+            return;
+        }
+        auto notifier = new QSocketNotifier(signalFds[1], QSocketNotifier::Read, qApp);
+        QObject::connect(notifier, &QSocketNotifier::activated, [](int fd) {
+            char c;
+            auto ret = ::read(fd, &c, sizeof(c));
+            Q_UNUSED(ret);
+            dump();
+        });
+    }
+    struct sigaction sa;
+    // recollinit 会把 SIGUSR1 换成 recollCleanup，已经是我们的就不用再装
+    if (sigaction(SIGUSR1, nullptr, &sa) == 0 && sa.sa_handler == onSigusr1) {
+        return;
+    }
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onSigusr1;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &sa, nullptr);
+}
@@ -0,0 +1,78 @@
+#ifndef QUERYTRACE_H
+#define QUERYTRACE_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+#include <atomic>
+
+/*
+ * 每次按键触发的查询分成几个阶段记录耗时：
+ * parse、expand（带展开后的词数）、match、rank、fetch、abstract、model update、first paint。
+ * 记录保存在一个环形缓冲区里，可以通过 D-Bus（DumpQueryTrace）或者 SIGUSR1
+ * 导出成 Chrome trace 的 JSON，用 chrome://tracing 或 Perfetto 查看。
+ */
+class QueryTrace
+{
+public:
+    struct Event {
+        quint64 query;
+        QString name;
+        qint64 startUs;
+        qint64 durUs;
+        quint64 tid;
+        QVariantMap args;
+    };
+
+    // 在作用域结束时记录一段
+    class Span
+    {
+    public:
+        explicit Span(const char *name);
+        ~Span();
+        void setArg(const QString &key, const QVariant &value) { m_args[key] = value; }
+
+    private:
+        const char *m_name;
+        quint64 m_query;
+        qint64 m_start;
+        QVariantMap m_args;
+    };
+
+    // 新的一次查询（一次按键），返回查询编号
+    static quint64 beginQuery(const QString &text);
+    // 当前查询在界面上画出来了，结束这次查询
+    static void endQuery();
+    static quint64 currentQuery() { return s_current; }
+
+    static void record(const QString &name, qint64 startUs, qint64 durUs,
+                       const QVariantMap &args = QVariantMap(), quint64 query = 0);
+    // 调用次数多的阶段（比如每一行的摘要）只累计，查询结束时合成一段
+    static void accumulate(const char *name, qint64 durUs);
+    static qint64 nowUs();
+
+    static QByteArray chromeJson();
+    // path 为空时写到 /tmp，返回实际写入的文件
+    static QString dump(const QString &path = QString());
+    // SIGUSR1 时导出。recollinit 也会设置 SIGUSR1 的处理函数，
+    // 要在它结束以后调用，可以重复调用
+    static void installSignalHandler();
+
+private:
+    static QElapsedTimer s_clock;
+    static QMutex s_mutex;
+    static QVector<Event> s_ring;
+    static int s_next;
+    static bool s_wrapped;
+    static std::atomic<quint64> s_current;
+    static qint64 s_queryStart;
+    static QString s_queryText;
+    static QHash<QString, QPair<qint64, int>> s_accumulated;
+};
+
+#endif // QUERYTRACE_H
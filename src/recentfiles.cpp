@@ -0,0 +1,92 @@
+#include "recentfiles.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QUrl>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+
+// 最多返回的条数
+static const int maxResults = 10;
+
+void RecentFilesProvider::reload()
+{
+    if (m_path.isEmpty()) {
+        m_path = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) +
+                 "/recently-used.xbel";
+    }
+    QFileInfo info(m_path);
+    if (!info.exists() || info.lastModified() == m_loaded) {
+        return;
+    }
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    m_loaded = info.lastModified();
+    m_entries.clear();
+    QXmlStreamReader xml(&file);
+    Entry entry;
+    while (!xml.atEnd()) {
+        xml.readNext();
+        if (xml.isStartElement()) {
+            if (xml.name() == "bookmark") {
+                auto attrs = xml.attributes();
+                entry = Entry();
+                entry.url = attrs.value("href").toString();
+                entry.fileName = QUrl(entry.url).fileName();
+                entry.modified = QDateTime::fromString(attrs.value("modified").toString(),
+                                                       Qt::ISODate);
+            } else if (xml.name() == "mime-type") {
+                entry.mimetype = xml.attributes().value("type").toString();
+            }
+        } else if (xml.isEndElement() && xml.name() == "bookmark") {
+            // 只要本地还存在的文件
+            if (entry.url.startsWith("file://") &&
+                QFileInfo::exists(QUrl(entry.url).toLocalFile())) {
+                m_entries.append(entry);
+            }
+        }
+    }
+    if (xml.hasError()) {
+        qDebug() << "RecentFilesProvider:" << m_path << xml.errorString();
+    }
+    std::sort(m_entries.begin(), m_entries.end(), [](const Entry &a, const Entry &b) {
+        return a.modified > b.modified;
+    });
+}
+
+std::vector<Rcl::Doc> RecentFilesProvider::query(const QString &text, int budgetMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    auto words = text.toLower().split(' ', QString::SkipEmptyParts);
+    std::vector<Rcl::Doc> docs;
+    if (words.isEmpty()) {
+        return docs;
+    }
+    QMutexLocker locker(&m_mutex);
+    reload();
+    for (int i = 0; i < m_entries.size() && int(docs.size()) < maxResults; i++) {
+        if (timer.elapsed() > budgetMs) {
+            break;
+        }
+        const auto &entry = m_entries[i];
+        auto lower = entry.fileName.toLower();
+        bool all = std::all_of(words.begin(), words.end(),
+                               [&lower](const QString &w) { return lower.contains(w); });
+        if (!all) {
+            continue;
+        }
+        // 文件名以第一个词开头的更相关，越近使用的越靠前
+        int score = (lower.startsWith(words.first()) ? 70 : 50) + qMax(0, 10 - i);
+        docs.push_back(makeDoc(entry.url, entry.mimetype, entry.fileName,
+                               QFileInfo(QUrl(entry.url).toLocalFile()).path(), score));
+    }
+    return docs;
+}
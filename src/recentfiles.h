@@ -0,0 +1,37 @@
+#ifndef RECENTFILES_H
+#define RECENTFILES_H
+
+#include "searchprovider.h"
+
+#include <QDateTime>
+#include <QMutex>
+#include <QVector>
+
+/*
+ * 最近使用的文件，来自 ~/.local/share/recently-used.xbel。
+ * 文件名包含所有输入的词时返回，文件改变时重新读取。
+ */
+class RecentFilesProvider : public SearchProvider
+{
+public:
+    QString name() const override { return "recent"; }
+    std::vector<Rcl::Doc> query(const QString &text, int budgetMs) override;
+
+private:
+    struct Entry {
+        QString url;
+        QString fileName;
+        QString mimetype;
+        QDateTime modified;
+    };
+    void reload();
+
+private:
+    QMutex m_mutex;
+    QString m_path;
+    QDateTime m_loaded;
+    // 最近的在前
+    QVector<Entry> m_entries;
+};
+
+#endif // RECENTFILES_H
@@ -1,14 +1,20 @@
 #include "recollmodel.h"
+#include "frecency.h"
+#include "querytrace.h"
 
 #include <bits/stl_list.h>
 #include <bits/stl_map.h>
 
 #include <QDebug>
+#include <QHash>
 #include <QIcon>
 #include <QMessageBox>
 #include <QPixmap>
+#include <QSet>
 #include <plaintorich.h>
 
+#include <iterator>
+
 class PlainToRichQtReslist : public PlainToRich {
 public:
     ~PlainToRichQtReslist() override = default;
@@ -21,6 +27,8 @@ public:
 };
 
 static PlainToRichQtReslist g_hiliter;
+// 每次滚动到底部追加的行数
+static const int pageSize = 30;
 
 static QString gengetter(const string &fld, const Rcl::Doc &doc) {
     const auto it = doc.meta.find(fld);
@@ -100,15 +108,6 @@ RecollModel::RecollModel(const QStringList fields, QObject *parent)
     o_displayableFields["date"] = tr("Date");
     o_displayableFields["datetime"] = tr("Date and time");
 
-    if (theconfig) {
-        const set<string> &stored = theconfig->getStoredFields();
-        for (const auto &it : stored) {
-            if (o_displayableFields.find(it) == o_displayableFields.end()) {
-                o_displayableFields[it] = QString::fromUtf8(it.c_str());
-            }
-        }
-    }
-
     // Construct the actual list of column names
     for (const auto &field : fields) {
         m_fields.emplace_back((const char *) (field.toUtf8()));
@@ -119,27 +118,204 @@ RecollModel::RecollModel(const QStringList fields, QObject *parent)
 }
 
 
-int RecollModel::rowCount(const QModelIndex &) const {
-    if (!m_source)
+void RecollModel::addStoredFields() {
+    if (!theconfig) {
+        return;
+    }
+    const set<string> &stored = theconfig->getStoredFields();
+    for (const auto &it : stored) {
+        if (o_displayableFields.find(it) == o_displayableFields.end()) {
+            o_displayableFields[it] = QString::fromUtf8(it.c_str());
+        }
+    }
+}
+
+int RecollModel::rowCount(const QModelIndex &parent) const {
+    if (parent.isValid())
         return 0;
-    auto cnt = m_source->getResCnt();
-    return cnt;
+    return int(m_rows.size());
+}
+
+bool RecollModel::canFetchMore(const QModelIndex &parent) const {
+    return !parent.isValid() && m_pagingEnabled && m_pager && m_pager->canFetchMore();
+}
+
+void RecollModel::fetchMore(const QModelIndex &parent) {
+    if (!canFetchMore(parent)) {
+        return;
+    }
+    // 显示的行去掉了重复的 key，和 m_pager 中的位置不一定相同
+    auto first = m_pager->getResCnt();
+    auto cnt = m_pager->prefetch(pageSize);
+    m_pager->showMore(cnt);
+    QSet<QString> seen;
+    for (const auto &row : m_rows) {
+        seen.insert(row.key);
+    }
+    std::vector<Row> more;
+    for (int i = first; i < first + cnt; i++) {
+        Rcl::Doc doc;
+        if (!m_pager->getDoc(i, doc)) {
+            break;
+        }
+        auto row = makeRow(doc);
+        if (!seen.contains(row.key)) {
+            seen.insert(row.key);
+            more.push_back(std::move(row));
+        }
+    }
+    if (!more.empty()) {
+        auto rows = rowCount(parent);
+        beginInsertRows(QModelIndex(), rows, rows + int(more.size()) - 1);
+        std::move(more.begin(), more.end(), std::back_inserter(m_rows));
+        endInsertRows();
+    }
+    emit resultCountChanged(rowCount(parent), estimatedTotal());
+}
+
+int RecollModel::estimatedTotal() const {
+    if (m_pager) {
+        return m_pager->estimatedTotal();
+    }
+    return int(m_rows.size());
+}
+
+bool RecollModel::getDoc(int row, Rcl::Doc &doc) const {
+    if (row < 0 || row >= int(m_rows.size())) {
+        return false;
+    }
+    doc = m_rows[row].doc;
+    return true;
+}
+
+RecollModel::Row RecollModel::makeRow(const Rcl::Doc &doc) const {
+    return {FrecencyStore::docKey(doc.url, doc.ipath), doc};
 }
 
 void RecollModel::readDocSource() {
-    beginResetModel();
-    endResetModel();
+    if (m_hasNext) {
+        m_source = std::move(m_nextSource);
+        m_pager = std::move(m_nextPager);
+        m_hasNext = false;
+    }
+    std::vector<Row> rows;
+    bool termsChanged = false;
+    if (m_source) {
+        // 查询执行之后才有高亮用的词
+        HighlightData hdata;
+        m_source->getTerms(hdata);
+        termsChanged = hdata.uterms != m_hdata.uterms;
+        m_hdata = hdata;
+        auto cnt = m_source->getResCnt();
+        QSet<QString> seen;
+        for (int i = 0; i < cnt; i++) {
+            Rcl::Doc doc;
+            if (!m_source->getDoc(i, doc)) {
+                break;
+            }
+            auto row = makeRow(doc);
+            // 对比时 key 必须唯一
+            if (!seen.contains(row.key)) {
+                seen.insert(row.key);
+                rows.push_back(std::move(row));
+            }
+        }
+    }
+    {
+        QueryTrace::Span span("model update");
+        applyRows(std::move(rows), termsChanged);
+    }
+    emit resultCountChanged(rowCount(QModelIndex()), estimatedTotal());
+}
+
+void RecollModel::applyRows(std::vector<Row> rows, bool termsChanged) {
+    QHash<QString, int> newPos;
+    for (int i = 0; i < int(rows.size()); i++) {
+        newPos.insert(rows[i].key, i);
+    }
+    // 删除新结果里没有的行，从后往前，连续的一起删
+    for (int i = int(m_rows.size()) - 1; i >= 0;) {
+        if (newPos.contains(m_rows[i].key)) {
+            i--;
+            continue;
+        }
+        int last = i;
+        while (i >= 0 && !newPos.contains(m_rows[i].key)) {
+            i--;
+        }
+        beginRemoveRows(QModelIndex(), i + 1, last);
+        m_rows.erase(m_rows.begin() + i + 1, m_rows.begin() + last + 1);
+        endRemoveRows();
+    }
+    // 剩下的行按新结果中的顺序排好
+    QSet<QString> current;
+    for (const auto &row : m_rows) {
+        current.insert(row.key);
+    }
+    std::vector<QString> kept;
+    for (const auto &row : rows) {
+        if (current.contains(row.key)) {
+            kept.push_back(row.key);
+        }
+    }
+    for (int i = 0; i < int(kept.size()); i++) {
+        if (m_rows[i].key == kept[i]) {
+            continue;
+        }
+        int j = i + 1;
+        while (m_rows[j].key != kept[i]) {
+            j++;
+        }
+        beginMoveRows(QModelIndex(), j, j, QModelIndex(), i);
+        auto row = std::move(m_rows[j]);
+        m_rows.erase(m_rows.begin() + j);
+        m_rows.insert(m_rows.begin() + i, std::move(row));
+        endMoveRows();
+    }
+    // 插入新的行，连续的一起插
+    for (int i = 0; i < int(rows.size());) {
+        if (i < int(m_rows.size()) && m_rows[i].key == rows[i].key) {
+            i++;
+            continue;
+        }
+        int first = i;
+        // 一直到下一个原有的行
+        while (i < int(rows.size()) &&
+               (first >= int(m_rows.size()) || m_rows[first].key != rows[i].key)) {
+            i++;
+        }
+        beginInsertRows(QModelIndex(), first, i - 1);
+        for (int k = first; k < i; k++) {
+            m_rows.insert(m_rows.begin() + k, rows[k]);
+        }
+        endInsertRows();
+    }
+    // 留下来的行换成新的文档，摘要和相关度可能不同
+    int changedFirst = -1;
+    for (int i = 0; i <= int(rows.size()); i++) {
+        bool changed = false;
+        if (i < int(rows.size())) {
+            const auto &o = m_rows[i].doc, &n = rows[i].doc;
+            changed = termsChanged || o.pc != n.pc || o.meta != n.meta;
+            m_rows[i].doc = std::move(rows[i].doc);
+        }
+        if (changed && changedFirst < 0) {
+            changedFirst = i;
+        } else if (!changed && changedFirst >= 0) {
+            emit dataChanged(index(changedFirst, 0), index(i - 1, 0));
+            changedFirst = -1;
+        }
+    }
 }
 
 void RecollModel::setDocSource(std::shared_ptr<DocSequence> nsource) {
+    m_nextPager = std::dynamic_pointer_cast<DocSeqRanked>(nsource);
     if (!nsource) {
-        m_source = std::shared_ptr<DocSequence>();
+        m_nextSource = std::shared_ptr<DocSequence>();
     } else {
-
-        m_source = std::shared_ptr<DocSequence>(new DocSource(theconfig, nsource));
-        m_hdata.clear();
-        m_source->getTerms(m_hdata);
+        m_nextSource = std::shared_ptr<DocSequence>(new DocSource(theconfig, nsource));
     }
+    m_hasNext = true;
 }
 
 QVariant RecollModel::headerData(int idx, Qt::Orientation orientation,
@@ -160,14 +336,14 @@ QVariant RecollModel::headerData(int idx, Qt::Orientation orientation,
 }
 
 QVariant RecollModel::data(const QModelIndex &index, int role) const {
-    if (!m_source || !index.isValid() || role < Qt::UserRole) {
+    if (!index.isValid() || role < Qt::UserRole) {
         return QVariant();
     }
-    Rcl::Doc doc;
     std::list<std::string> lr;
-    if (!m_source->getDoc(index.row(), doc)) {
+    if (index.row() >= int(m_rows.size())) {
         return QVariant();
     }
+    const auto &doc = m_rows[index.row()].doc;
     QVariant var;
     switch (role) {
         case Role_FILE_NAME: {
@@ -179,9 +355,12 @@ QVariant RecollModel::data(const QModelIndex &index, int role) const {
             break;
         }
         case Role_FILE_SIMPLE_CONTENT: {
+            auto start = QueryTrace::nowUs();
             var = gengetter("abstract", doc);
             g_hiliter.plaintorich(var.toString().toStdString(), lr, m_hdata);
             var = QString::fromUtf8(lr.front().c_str());
+            // 每一行都会调用，只累计
+            QueryTrace::accumulate("abstract", QueryTrace::nowUs() - start);
             break;
         }
         case Role_MIME_TYPE: {
@@ -217,6 +396,14 @@ QVariant RecollModel::data(const QModelIndex &index, int role) const {
             var = gengetter("appnodisplay", doc);
             break;
         }
+        case Role_APP_EXEC: {
+            var = gengetter("appexec", doc);
+            break;
+        }
+        case Role_GROUP: {
+            var = DocSeqRanked::groupOf(doc);
+            break;
+        }
         default:
             break;
     }
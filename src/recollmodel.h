@@ -4,6 +4,8 @@
 #include <QAbstractListModel>
 #include <docseq.h>
 
+#include "docseqranked.h"
+
 #include <bits/shared_ptr.h>
 extern RclConfig *theconfig;
 typedef QString (FieldGetter)(const std::string &fldname,
@@ -26,6 +28,9 @@ public:
         Role_APP_NAME=Qt::UserRole+8,
         Role_VIEW_TYPE=Qt::UserRole+9,
         Role_NODISPLAY=Qt::UserRole+10,
+        Role_APP_EXEC=Qt::UserRole+11,
+        // DocSeqRanked::groupOf 的分组
+        Role_GROUP=Qt::UserRole+12,
     };
 
 public:
@@ -35,27 +40,60 @@ public:
 
     // Reimplemented methods
     int rowCount(const QModelIndex &) const override;
+    // 滚动到底部时再从 DocSeqRanked 取下一页
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    // 估计的结果总数，不知道时返回已经显示的行数
+    int estimatedTotal() const;
+    // 查询线程在用数据库时不能在界面线程里取下一页
+    void setPagingEnabled(bool enabled) { m_pagingEnabled = enabled; }
 
     QVariant headerData(int col, Qt::Orientation orientation,
                               int role ) const override;
 
     QVariant data(const QModelIndex &index,
                         int role ) const override;
+  // 用 setDocSource 设置的新结果替换当前的行，只发出变化部分的信号
   virtual void readDocSource();
+  // 新结果在 readDocSource 之前不会显示，旧的行一直留在界面上
   virtual void setDocSource(std::shared_ptr<DocSequence> nsource);
   virtual std::shared_ptr<DocSequence> getDocSource() { return m_source; }
+  // 当前显示的第 row 行对应的文档
+  bool getDoc(int row, Rcl::Doc &doc) const;
   virtual const std::vector<std::string> &getFields() { return m_fields; }
   virtual const std::map<std::string, QString> &getAllFields() {
     return o_displayableFields;
   }
+  // theconfig 中保存的字段也可以显示，theconfig 在后台线程里创建，
+  // 后端准备好（MainWindow::setBackendReady）之后才能调用
+  static void addStoredFields();
 
 
 signals:
   void sortDataChanged(DocSeqSortSpec);
+  void resultCountChanged(int shown, int estimated);
 
   friend class ResTable;
 private:
+  struct Row {
+      // FrecencyStore::docKey，两次结果之间用它对应同一个文档
+      QString key;
+      Rcl::Doc doc;
+  };
+  Row makeRow(const Rcl::Doc &doc) const;
+  // 把 m_rows 变成 rows：删除、移动、插入，最后对内容变了的行发 dataChanged
+  void applyRows(std::vector<Row> rows, bool termsChanged);
+
   mutable std::shared_ptr<DocSequence> m_source;
+  // m_source 包装的分页序列，没有时不能加载更多
+  std::shared_ptr<DocSeqRanked> m_pager;
+  // 等待 readDocSource 的新结果
+  std::shared_ptr<DocSequence> m_nextSource;
+  std::shared_ptr<DocSeqRanked> m_nextPager;
+  bool m_hasNext{false};
+  bool m_pagingEnabled{true};
+  // 当前显示的行，data() 只读这里
+  std::vector<Row> m_rows;
   std::vector<std::string> m_fields;
   std::vector<FieldGetter *> m_getters;
   static std::map<std::string, QString> o_displayableFields;
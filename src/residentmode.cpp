@@ -0,0 +1,152 @@
+#include "residentmode.h"
+#include "querycompiler.h"
+#include "startuptrace.h"
+
+#include <QApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QLayout>
+#include <QSettings>
+#include <QWidget>
+
+#include <algorithm>
+#include <memory>
+
+#include <log.h>
+#include <rcldb.h>
+#include <rcldoc.h>
+#include <rclquery.h>
+#include <searchdata.h>
+
+extern RclConfig *theconfig;
+
+static const int maxSamples = 64;
+// 每个前缀最多展开的词数
+static const int primeTermsPerPrefix = 16;
+// 每个查询读取的文档数，和第一屏结果差不多
+static const int primeDocsPerQuery = 20;
+// 唤出后这么久还没有绘制（比如马上又被隐藏了），放弃这次计时
+static const int summonTimeoutMs = 5000;
+
+ResidentMode *ResidentMode::instance()
+{
+    static auto instance = new ResidentMode(qApp);
+    return instance;
+}
+
+ResidentMode::ResidentMode(QObject *parent) : QObject(parent)
+{
+}
+
+void ResidentMode::prepareWindow(QWidget *window)
+{
+    window->ensurePolished();
+    if (window->layout() != nullptr) {
+        window->layout()->activate();
+    }
+    // 创建原生窗口并离屏绘制一次，字体、图标和样式缓存都会在这里加载
+    window->winId();
+    window->grab();
+    StartupTrace::mark("prepare window");
+}
+
+QStringList ResidentMode::primeQueries()
+{
+    // 默认是常见的单字母前缀，可以在配置里换成自己常搜的词
+    QStringList def;
+    for (char c = 'a'; c <= 'z'; c++) {
+        def << QString(QChar(c)) + "*";
+    }
+    return QSettings().value("resident/primeQueries", def).toStringList();
+}
+
+void ResidentMode::primeDb(Rcl::Db *db)
+{
+    if (db == nullptr || !db->isopen()) {
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    int terms = 0, docs = 0;
+    for (const auto &q : primeQueries()) {
+        // 前缀展开会遍历词表的 B 树
+        Rcl::TermMatchResult result;
+        if (!db->termMatch(Rcl::Db::ET_WILD, "", q.toStdString(), result,
+                           primeTermsPerPrefix)) {
+            continue;
+        }
+        if (result.entries.empty()) {
+            continue;
+        }
+        // 用最常见的词查询一次，读入倒排表和文档数据
+        auto top = std::max_element(result.entries.begin(), result.entries.end(),
+                                    [](const Rcl::TermMatchEntry &a, const Rcl::TermMatchEntry &b) {
+                                        return a.wcf < b.wcf;
+                                    });
+        terms += result.entries.size();
+        auto sdata = std::make_shared<Rcl::SearchData>(Rcl::SCLT_AND,
+                                                         QueryCompiler::stemLang(db->getConf()));
+        sdata->addClause(new Rcl::SearchDataClauseSimple(Rcl::SCLT_AND, top->term));
+        Rcl::Query query(db);
+        if (!query.setQuery(sdata)) {
+            continue;
+        }
+        int cnt = std::min(query.getResCnt(), primeDocsPerQuery);
+        for (int i = 0; i < cnt; i++) {
+            Rcl::Doc doc;
+            if (query.getDoc(i, doc)) {
+                docs++;
+            }
+        }
+    }
+    LOGDEB("ResidentMode::primeDb: " << terms << " terms, " << docs << " docs in "
+           << timer.elapsed() << " ms\n");
+    StartupTrace::mark("prime db", true);
+}
+
+void ResidentMode::summonStarted(QWidget *window)
+{
+    if (m_measuring && m_summonClock.elapsed() < summonTimeoutMs) {
+        return;
+    }
+    m_measuring = true;
+    m_summonClock.start();
+    // 超时的那次的回调可能在之后的绘制里才触发，用序号区分
+    auto id = ++m_summonId;
+    StartupTrace::onFirstPaint(window, [this, id]() {
+        if (id != m_summonId) {
+            return;
+        }
+        auto ms = m_summonClock.elapsed();
+        m_measuring = false;
+        m_summons++;
+        m_samples.append(ms);
+        if (m_samples.size() > maxSamples) {
+            m_samples.removeFirst();
+        }
+        qDebug() << "ResidentMode: summon to first frame" << ms << "ms";
+        emit summonLatency(ms);
+    });
+}
+
+QVariantMap ResidentMode::summonStats() const
+{
+    QVariantMap map;
+    map["resident"] = m_resident;
+    map["summons"] = m_summons;
+    if (m_samples.isEmpty()) {
+        return map;
+    }
+    auto sorted = m_samples;
+    std::sort(sorted.begin(), sorted.end());
+    qint64 sum = 0;
+    for (auto ms : sorted) {
+        sum += ms;
+    }
+    map["lastMs"] = m_samples.last();
+    map["avgMs"] = double(sum) / sorted.size();
+    map["p50Ms"] = sorted[sorted.size() / 2];
+    map["p95Ms"] = sorted[qMin(sorted.size() - 1, sorted.size() * 95 / 100)];
+    map["maxMs"] = sorted.last();
+    return map;
+}
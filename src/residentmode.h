@@ -0,0 +1,57 @@
+#ifndef RESIDENTMODE_H
+#define RESIDENTMODE_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QStringList>
+#include <QVariantMap>
+#include <QVector>
+
+class QWidget;
+namespace Rcl {
+class Db;
+}
+
+/*
+ * 常驻模式：登录时以 --resident 启动，窗口提前构造并完成布局和一次绘制，
+ * 但不显示；数据库打开后用一组查询把词表和倒排表的页面读进缓存。
+ * 之后唤出窗口只是 show 一个已经准备好的窗口。
+ *
+ * 同时记录每次唤出（快捷键、D-Bus showWindow、托盘）到窗口第一次绘制的耗时。
+ */
+class ResidentMode : public QObject
+{
+    Q_OBJECT
+public:
+    static ResidentMode *instance();
+
+    bool isResident() const { return m_resident; }
+    void setResident(bool resident) { m_resident = resident; }
+
+    // 不显示窗口，只完成样式、布局和一次离屏绘制
+    void prepareWindow(QWidget *window);
+    // 在后台线程调用，数据库已经打开
+    static void primeDb(Rcl::Db *db);
+
+    // 即将显示窗口时调用，窗口第一次绘制后记录耗时
+    void summonStarted(QWidget *window);
+    QVariantMap summonStats() const;
+
+signals:
+    void summonLatency(qint64 ms);
+
+private:
+    explicit ResidentMode(QObject *parent = nullptr);
+    static QStringList primeQueries();
+
+private:
+    bool m_resident{false};
+    bool m_measuring{false};
+    quint64 m_summonId{0};
+    QElapsedTimer m_summonClock;
+    // 最近的若干次耗时
+    QVector<qint64> m_samples;
+    quint64 m_summons{0};
+};
+
+#endif // RESIDENTMODE_H
@@ -1,15 +1,15 @@
 #include <utility>
 
+#include "frecency.h"
+#include "launcher.h"
 #include "reslistwidget.h"
+#include "restabledelegate.h"
 
 #include <QDebug>
 #include <QHeaderView>
 #include <QMessageBox>
-#include <QPainter>
-#include <QProcess>
 #include <QShortcut>
 #include <QSizePolicy>
-#include <QStyledItemDelegate>
 #include <QTextDocument>
 #include <QTimer>
 #include <QVBoxLayout>
@@ -17,86 +17,9 @@
 
 #define TEXTINCELLVTRANS -1
 
-class ResTableDelegate : public QStyledItemDelegate {
-public:
-    explicit ResTableDelegate(QObject *parent) : QStyledItemDelegate(parent) {}
-
-    void paint(QPainter *painter, const QStyleOptionViewItem &option,
-               const QModelIndex &index) const override {
-        QStyleOptionViewItem opt = option;
-        initStyleOption(&opt, index);
-        auto itemType =
-                index.data(RecollModel::ModelRoles::Role_VIEW_TYPE).toString();
-        auto mimeType =
-                index.data(RecollModel::ModelRoles::Role_MIME_TYPE).toString();
-        if (itemType == "SECTION") {
-            painter->drawText(opt.rect.adjusted(-1, -1, -1, -1), mimeType);
-            if (opt.state & QStyle::State_Selected) {
-                painter->fillRect(opt.rect, opt.palette.highlight());
-            }
-            return;
-        } else if (itemType == "DOT") {
-            painter->drawText(opt.rect.center(), "...");
-            if (opt.state & QStyle::State_Selected) {
-                painter->fillRect(opt.rect, opt.palette.highlight());
-            }
-            return;
-        }
-
-//    } else if (itemType == "ITEM") {
-
-        auto filename =
-                index.data(RecollModel::ModelRoles::Role_FILE_NAME).toString();
-        if (index.data(RecollModel::ModelRoles::Role_MIME_TYPE).toString() ==
-            "application/x-all") {
-            // TODO find app icon
-            filename =
-                    index.data(RecollModel::ModelRoles::Role_APP_NAME).toString();
-        }
-        auto iconpath =
-                index.data(RecollModel::ModelRoles::Role_ICON_PATH).toString();
-
-        QPixmap icon(iconpath);
-        if (icon.isNull()) {
-            qDebug() << "null icon:" << iconpath;
-        }
-        icon = icon.scaled(this->sizeHint(option, index));
-        QRectF recf(opt.rect);
-        if (opt.state & QStyle::State_Selected) {
-            painter->fillRect(opt.rect, opt.palette.highlight());
-        }
-        QRectF iconRectf(opt.rect);
-        iconRectf.setSize(icon.size());
-
-        painter->drawPixmap(iconRectf, icon, icon.rect());
-
-        auto textPos = QPointF(iconRectf.topRight());
-
-        textPos.ry() += iconRectf.height() / 2;
-        painter->drawText(textPos, filename);
-    }
-
-public:
-    QSize sizeHint(const QStyleOptionViewItem &option,
-                   const QModelIndex &index) const override {
-
-        //TODO hidpi?
-        auto itemType =
-                index.data(RecollModel::ModelRoles::Role_VIEW_TYPE).toString();
-        if (itemType == "SECTION") {
-
-
-            return {200, 25};
-        } else if (itemType == "DOT") {
-
-            return {200, 25};
-        }
-        return {50, 50};
-    }
-};
-
 void ResTable::init_conn() {
     connect(this, &ResTable::currentChanged, this, &ResTable::onTableView_currentChanged);
+    connect(m_model, &RecollModel::resultCountChanged, this, &ResTable::resultCountChanged);
 }
 
 ResTable::ResTable(QWidget *parent)
@@ -157,7 +80,7 @@ void ResTable::onTableView_currentChanged() {
     auto index = listview->model()->index(mdetailRow, 0);
     index=currentFilterModel->mapToSource(index);
     Rcl::Doc doc;
-    this->m_model->getDocSource()->getDoc(index.row(), doc);
+    this->m_model->getDoc(index.row(), doc);
 
     HighlightData hl;
     this->m_model->getDocSource()->getTerms(hl);
@@ -203,7 +126,15 @@ void ResTable::resetSource() {
 
 void ResTable::readDocSource(bool resetPos) {
     m_model->readDocSource();
-    this->dtw->hide();
+    // 模型只发出变化的部分，当前行还在的话选择和详情都保留
+    auto cidx = listview->currentIndex();
+    if (!cidx.isValid()) {
+        mdetailRow = -1;
+        this->dtw->hide();
+    } else if (this->dtw->isVisible()) {
+        mdetailRow = cidx.row();
+        emit currentChanged();
+    }
 }
 
 void ResTable::clearSeach() {
@@ -216,7 +147,7 @@ void ResTable::returnPressed() {
     if(!currentIndex.isValid()){
         return;
     }
-    currentIndex=currentFilterModel->mapToSource(listview->currentIndex());
+    // 分组和 "..." 行在源模型里没有对应的行，要从代理模型取
     auto vtype = currentIndex.data(RecollModel::Role_VIEW_TYPE).toString();
     if (vtype == "DOT" || vtype == "SECTION") {
         emit filterChanged(
@@ -227,19 +158,23 @@ void ResTable::returnPressed() {
         //TODO
 //    proxyModel->setSourceModel(m_model);
     }
+    currentIndex=currentFilterModel->mapToSource(currentIndex);
     auto mime =
             currentIndex.data(RecollModel::ModelRoles::Role_MIME_TYPE).toString();
     auto path =
             currentIndex.data(RecollModel::ModelRoles::Role_LOCATION).toString();
-    QString aname;
-    QStringList args;
+    path.replace("file://", "");
+    Rcl::Doc doc;
+    if (this->m_model->getDoc(currentIndex.row(), doc)) {
+        emit docOpened(FrecencyStore::docKey(doc.url, doc.ipath));
+    }
     if (mime == "application/x-all") {
-        aname="dex";
+        auto exec =
+                currentIndex.data(RecollModel::ModelRoles::Role_APP_EXEC).toString();
+        Launcher::instance()->launchDesktopFile(path, exec);
     } else {
-        aname="xdg-open";
+        Launcher::instance()->openFile(path, mime);
     }
-    args<<path.replace("file://", "");
-    QProcess::startDetached(aname,args,"/tmp");
 }
 
 void ResTable::currentMoveUp() {
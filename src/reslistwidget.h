@@ -39,6 +39,8 @@ public:
     ~ResTable() override = default;
 
     virtual RecollModel *getModel() { return m_model; }
+    // 实际绘制结果的控件，用来判断结果什么时候画出来
+    QWidget *resultView() { return listview->viewport(); }
 
 private:
   void init_ui();
@@ -58,7 +60,11 @@ public slots:
 
 signals:
   void filterChanged(QString filed);
+  // 用户打开了一个结果，参数是 FrecencyStore::docKey
+  void docOpened(QString docKey);
   void currentChanged();
+  // 已经显示的行数和估计的结果总数
+  void resultCountChanged(int shown, int estimated);
 private:
   DListView *listview;
   QSortFilterProxyModel *filterNone;
@@ -0,0 +1,20 @@
+#ifndef RESTABLEDELEGATE_H
+#define RESTABLEDELEGATE_H
+
+#include <QStyledItemDelegate>
+
+/*
+ * 结果列表每一行的绘制：分组标题、"..." 和带图标的结果。
+ * 不依赖 ResTable，bench/ 里的基准测试直接使用。
+ */
+class ResTableDelegate : public QStyledItemDelegate {
+public:
+    explicit ResTableDelegate(QObject *parent) : QStyledItemDelegate(parent) {}
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option,
+               const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option,
+                   const QModelIndex &index) const override;
+};
+
+#endif // RESTABLEDELEGATE_H
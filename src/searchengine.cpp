@@ -0,0 +1,235 @@
+#include "searchengine.h"
+
+#include <QStringList>
+#include <QVector>
+
+#include <algorithm>
+
+#include <docseqdb.h>
+#include <hldata.h>
+#include <log.h>
+#include <rcldb.h>
+#include <rclquery.h>
+
+#include "appindex.h"
+#include "config.h"
+#include "fuzzyindex.h"
+#include "pathindex.h"
+#include "querycompiler.h"
+#include "querytrace.h"
+#include "recentfiles.h"
+#include "searchprovider.h"
+
+const int SearchEngine::fuzzyMinResults = 3;
+const int SearchEngine::strongMatchScore = 70;
+const int SearchEngine::nameHitsTopK = 20;
+const int SearchEngine::providerBudgetMs = 120;
+// 每个词最多加入的近似词
+static const int fuzzyMaxPerWord = 3;
+// 估计结果总数时 Xapian 至少检查的文档数，比第一页多一些就够了
+static const int estimateCheckAtLeast = 100;
+// search() 在最后一批之前最多再等迟到的来源这么久
+static const int lateWaitMs = 1000;
+
+void SearchEngine::registerProviders(std::shared_ptr<PathIndex> pathIndex)
+{
+    auto hub = ProviderHub::instance();
+    // 应用不在 recoll 的索引里，放在第一个
+    hub->add(std::make_shared<AppIndex>());
+    hub->add(std::make_shared<RecentFilesProvider>());
+    if (pathIndex) {
+        hub->add(std::move(pathIndex));
+    }
+}
+
+SearchEngine::Pass SearchEngine::prepare(std::shared_ptr<Rcl::Db> db,
+                                         std::shared_ptr<Rcl::SearchData> sdata,
+                                         const QString &text, const std::string &title,
+                                         int pageSize)
+{
+    Pass pass;
+    pass.query = std::make_shared<Rcl::Query>(db.get());
+    pass.query->setCollapseDuplicates(true);
+    pass.sdata = sdata;
+    // 没有过滤条件时 DocSequenceDb 不会自己 setQuery，由 execute 来做，
+    // 这样展开通配符的时间可以单独统计
+    auto src = std::make_shared<DocSequenceDb>(pass.query, title, std::move(sdata));
+    src->setAbstractParams(true, false);
+    pass.source = src;
+    // 分组和常用条目加分在 DocSeqRanked 中完成
+    pass.ranked = std::make_shared<DocSeqRanked>(pass.source, text, pageSize);
+    pass.ranked->keepDb(db);
+    pass.db = std::move(db);
+    return pass;
+}
+
+int SearchEngine::execute(const Pass &pass, bool estimateTotal)
+{
+    {
+        QueryTrace::Span span("expand");
+        pass.query->setQuery(pass.sdata);
+        HighlightData hld;
+        pass.sdata->getTerms(hld);
+        span.setArg("terms", int(hld.terms.size()));
+    }
+    if (estimateTotal) {
+        // 只要估计值，不让 Xapian 为了精确计数（去重时尤其慢）遍历全部匹配
+        QueryTrace::Span span("match");
+        auto estimate = pass.query->getResCnt(estimateCheckAtLeast, true);
+        span.setArg("estimate", estimate);
+        pass.ranked->setEstimate(estimate);
+    }
+    return pass.ranked->getResCnt();
+}
+
+std::vector<Rcl::Doc> SearchEngine::docs(DocSeqRanked &ranked, int limit)
+{
+    int cnt = ranked.getResCnt();
+    while (cnt < limit && ranked.canFetchMore()) {
+        int got = ranked.prefetch(limit - cnt);
+        if (got <= 0) {
+            break;
+        }
+        ranked.showMore(got);
+        cnt = ranked.getResCnt();
+    }
+    std::vector<Rcl::Doc> out;
+    for (int i = 0; i < cnt && (limit < 0 || i < limit); i++) {
+        Rcl::Doc doc;
+        if (ranked.getDoc(i, doc)) {
+            out.push_back(std::move(doc));
+        }
+    }
+    return out;
+}
+
+bool SearchEngine::needsFuzzy(int recollHits, const std::vector<Rcl::Doc> &provided)
+{
+    if (recollHits >= fuzzyMinResults) {
+        return false;
+    }
+    // 比如输入 fire 找到了 Firefox，再查 fine、hire 只会把它挤掉
+    return std::none_of(provided.begin(), provided.end(),
+                        [](const Rcl::Doc &doc) { return doc.pc >= strongMatchScore; });
+}
+
+std::shared_ptr<Rcl::SearchData> SearchEngine::fuzzyQuery(const QString &text,
+                                                          const RclConfig *config)
+{
+    // 和正常查询一样分类，只给普通词加上近似词
+    auto tokens = QueryCompiler::tokenize(text);
+    QVector<QStringList> alternatives(tokens.size());
+    bool expanded = false;
+    for (int i = 0; i < tokens.size(); i++) {
+        if (tokens[i].kind != QueryCompiler::TK_WORD &&
+            tokens[i].kind != QueryCompiler::TK_PREFIX) {
+            continue;
+        }
+        for (const auto &sug : FuzzyIndex::instance()->suggest(tokens[i].text, fuzzyMaxPerWord)) {
+            alternatives[i] << sug.term;
+            expanded = true;
+        }
+    }
+    if (!expanded) {
+        return nullptr;
+    }
+    LOGDEB("SearchEngine::fuzzyQuery: " << QueryCompiler::describe(tokens).toStdString() << "\n");
+    return QueryCompiler::compile(tokens, alternatives, config);
+}
+
+bool SearchEngine::search(const std::shared_ptr<Rcl::Db> &db, const QString &text, int limit,
+                          const BatchHandler &onBatch, QString *error)
+{
+    auto config = db->getConf();
+    auto sdata = QueryCompiler::compile(text, config);
+    if (!sdata) {
+        *error = "nothing to search for";
+        return false;
+    }
+    // 其它来源和 recoll 查询同时进行
+    auto hub = ProviderHub::instance();
+    auto round = hub->startDetached(text, providerBudgetMs);
+
+    // 先只查文件名和标题
+    std::vector<Rcl::Doc> leading;
+    if (auto names = QueryCompiler::compileNames(text, config)) {
+        auto pass = prepare(db, std::move(names), text, "Name matches", nameHitsTopK);
+        QueryTrace::Span span("name pass");
+        execute(pass, false);
+        leading = docs(*pass.ranked, -1);
+        span.setArg("docs", int(leading.size()));
+        if (!leading.empty()) {
+            std::vector<Rcl::Doc> first(leading.begin(),
+                                        leading.begin() + qMin(int(leading.size()), limit));
+            onBatch({"names", std::move(first), false});
+        }
+    }
+
+    auto pass = prepare(db, sdata, text, "Query results");
+    // 全文查询的结果接在名字的后面
+    pass.ranked->setLeading(std::move(leading));
+    execute(pass);
+    // 截止时间之前完成的其它来源和第一页一起排序
+    auto provided = hub->collect(round);
+    bool fuzzy = needsFuzzy(pass.ranked->sourceCount(), provided);
+    pass.ranked->merge(std::move(provided));
+    if (fuzzy) {
+        if (auto fsdata = fuzzyQuery(text, config)) {
+            // 容错查询不分阶段，第一次的名字和其它来源的结果保留
+            auto retry = prepare(db, std::move(fsdata), text, "Query results");
+            retry.ranked->setLeading(pass.ranked->leadingDocs());
+            execute(retry);
+            retry.ranked->merge(pass.ranked->mergedDocs());
+            pass = std::move(retry);
+        }
+    }
+    auto shown = docs(*pass.ranked, limit);
+    auto late = hub->finish(round, lateWaitMs);
+    onBatch({"ranked", std::move(shown), late.empty()});
+    if (!late.empty()) {
+        int before = pass.ranked->getResCnt();
+        pass.ranked->append(std::move(late));
+        std::vector<Rcl::Doc> added;
+        for (int i = before; i < pass.ranked->getResCnt() && i < limit; i++) {
+            Rcl::Doc doc;
+            if (pass.ranked->getDoc(i, doc)) {
+                added.push_back(std::move(doc));
+            }
+        }
+        onBatch({"late", std::move(added), true});
+    }
+    return true;
+}
+
+static QString metaValue(const Rcl::Doc &doc, const std::string &key)
+{
+    auto it = doc.meta.find(key);
+    return it != doc.meta.end() ? QString::fromStdString(it->second) : QString();
+}
+
+QVariantMap SearchEngine::toVariant(const Rcl::Doc &doc)
+{
+    QVariantMap map;
+    map["url"] = QString::fromStdString(doc.url);
+    map["ipath"] = QString::fromStdString(doc.ipath);
+    map["mimetype"] = QString::fromStdString(doc.mimetype);
+    map["group"] = DocSeqRanked::groupOf(doc);
+    map["score"] = doc.pc;
+    auto title = metaValue(doc, "appname");
+    if (title.isEmpty()) {
+        title = metaValue(doc, Rcl::Doc::keytt);
+    }
+    if (title.isEmpty()) {
+        title = metaValue(doc, Rcl::Doc::keyfn);
+    }
+    map["title"] = title;
+    map["abstract"] = metaValue(doc, Rcl::Doc::keyabs);
+    // 程序才有的字段
+    for (const char *key : {"appexec", "appicon", "appcomment"}) {
+        auto value = metaValue(doc, key);
+        if (!value.isEmpty()) {
+            map[key] = value;
+        }
+    }
+    return map;
+}
@@ -0,0 +1,85 @@
+#ifndef SEARCHENGINE_H
+#define SEARCHENGINE_H
+
+#include <QString>
+#include <QVariantMap>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <rcldoc.h>
+#include <searchdata.h>
+
+#include "docseqranked.h"
+
+class PathIndex;
+class RclConfig;
+namespace Rcl {
+class Db;
+class Query;
+}
+
+/*
+ * 不依赖界面的查询流程：编译、执行、分组、重排。
+ * MainWindow 把 prepare/execute 放在查询线程里一步一步执行；
+ * 命令行工具 everylauncher-query 和 D-Bus 的 Search 用 search() 执行整个流程。
+ * 所有函数都在调用线程里同步执行，同一个 Rcl::Db 不能同时在两个线程里查询。
+ */
+class SearchEngine
+{
+public:
+    // recoll 的结果少于这个数时用拼写容错再查一次
+    static const int fuzzyMinResults;
+    // 其它来源有这个分数以上的结果（名字以输入开头）时不做容错查询
+    static const int strongMatchScore;
+    // 第一阶段（文件名、标题）最多取的结果数
+    static const int nameHitsTopK;
+    // 每次查询等其它来源的时间，从开始查询算起
+    static const int providerBudgetMs;
+
+    // 一次 recoll 查询：DocSequenceDb 外面包上 DocSeqRanked
+    struct Pass {
+        std::shared_ptr<Rcl::Db> db;
+        std::shared_ptr<Rcl::Query> query;
+        std::shared_ptr<Rcl::SearchData> sdata;
+        std::shared_ptr<DocSequence> source;
+        std::shared_ptr<DocSeqRanked> ranked;
+    };
+
+    // 一批结果。stage 为 "names" 和 "ranked" 时替换之前的结果，
+    // 为 "late" 时接在后面，最后一批的 final 为 true
+    struct Batch {
+        QString stage;
+        std::vector<Rcl::Doc> docs;
+        bool final;
+    };
+    using BatchHandler = std::function<void(const Batch &)>;
+
+    // 程序、最近文件和路径索引，界面和命令行用同一组来源
+    static void registerProviders(std::shared_ptr<PathIndex> pathIndex);
+
+    // ranked 持有 db，换了数据库以后旧的结果仍然可以翻页
+    static Pass prepare(std::shared_ptr<Rcl::Db> db, std::shared_ptr<Rcl::SearchData> sdata,
+                        const QString &text, const std::string &title, int pageSize = 50);
+    // 展开通配符、估计总数、取第一页并重排，返回第一页的条数
+    static int execute(const Pass &pass, bool estimateTotal = true);
+    // 按显示顺序取出最多 limit 条，limit 比第一页多时按页继续取
+    static std::vector<Rcl::Doc> docs(DocSeqRanked &ranked, int limit);
+    // recollHits 只算 recoll 的结果，其它来源已经有很匹配的结果时不需要容错
+    static bool needsFuzzy(int recollHits, const std::vector<Rcl::Doc> &provided);
+    // 按 QueryCompiler::tokenize 分类，普通词换成 "词 OR 近似词..."，没有近似词时返回空
+    static std::shared_ptr<Rcl::SearchData> fuzzyQuery(const QString &text,
+                                                       const RclConfig *config = nullptr);
+
+    // 完整的一次查询：名字、全文加上其它来源、结果太少时的容错查询、迟到的来源。
+    // 只用 db 自己的配置副本，可以在界面线程以外调用
+    static bool search(const std::shared_ptr<Rcl::Db> &db, const QString &text, int limit,
+                       const BatchHandler &onBatch, QString *error);
+
+    // D-Bus 和命令行 --json 输出的字段
+    static QVariantMap toVariant(const Rcl::Doc &doc);
+};
+
+#endif // SEARCHENGINE_H
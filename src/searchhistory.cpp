@@ -0,0 +1,44 @@
+#include "searchhistory.h"
+
+#include <QSettings>
+
+static const char *keyHistory = "history/queries";
+static const int maxHistory = 200;
+
+void SearchHistory::add(const QString &query)
+{
+    auto q = query.simplified();
+    if (q.isEmpty()) {
+        return;
+    }
+    auto list = all();
+    list.removeAll(q);
+    list.prepend(q);
+    while (list.size() > maxHistory) {
+        list.removeLast();
+    }
+    QSettings().setValue(keyHistory, list);
+}
+
+QStringList SearchHistory::all()
+{
+    return QSettings().value(keyHistory).toStringList();
+}
+
+QStringList SearchHistory::matching(const QString &text, int max)
+{
+    QStringList out;
+    auto t = text.simplified();
+    if (t.isEmpty()) {
+        return out;
+    }
+    for (const auto &q : all()) {
+        if (q.startsWith(t, Qt::CaseInsensitive) && q.compare(t, Qt::CaseInsensitive) != 0) {
+            out << q;
+            if (out.size() >= max) {
+                break;
+            }
+        }
+    }
+    return out;
+}
@@ -0,0 +1,19 @@
+#ifndef SEARCHHISTORY_H
+#define SEARCHHISTORY_H
+
+#include <QStringList>
+
+/*
+ * 搜索历史，保存在 QSettings 的 history/queries 中，最近的在前。
+ * 用户从结果里打开了东西时记录当时的查询。
+ */
+class SearchHistory
+{
+public:
+    static void add(const QString &query);
+    static QStringList all();
+    // 以 text 开头的历史记录，不区分大小写
+    static QStringList matching(const QString &text, int max);
+};
+
+#endif // SEARCHHISTORY_H
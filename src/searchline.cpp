@@ -9,6 +9,10 @@
 #include <QAbstractItemView>
 #include <QAbstractListModel>
 #include <QCompleter>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QKeySequence>
 #include <QListView>
 #include <QModelIndex>
@@ -26,11 +30,14 @@
 #include <qwhatsthis.h>
 
 #include "log.h"
+#include "querycompiler.h"
+#include "querytrace.h"
 #include "rcldb.h"
+#include "searchhistory.h"
 #include "searchdata.h"
 #include "smallut.h"
+#include "termdict.h"
 #include "textsplit.h"
-#include "wasatorcl.h"
 
 using namespace std;
 
@@ -65,36 +72,29 @@ QVariant KeyWordsCompleterModel::data(const QModelIndex &index, int role) const
   }
 }
 
-void KeyWordsCompleterModel::onPartialWord(int tp, const QString &_qtext,
+void KeyWordsCompleterModel::onPartialWord(int tp, const QString &qtext,
                                       const QString &qpartial) {
-//  string partial = qpartial.toStdString();
-//  QString qtext = _qtext.trimmed();
-//  bool onlyspace = qtext.isEmpty();
-
-  currentlist.clear();
+  Q_UNUSED(tp);
   beginResetModel();
-  int histmatch = 0;
+  currentlist.clear();
 
+  // 历史记录在前，用时钟图标
+  for (const auto &hist : SearchHistory::matching(qtext, maxhistmatch)) {
+    currentlist.push_back(hist);
+  }
   firstfromindex = currentlist.size();
 
-  /*
-  if (!qpartial.trimmed().isEmpty()) {
-    Rcl::TermMatchResult rclmatches;
-    if (!rcldb->termMatch(Rcl::Db::ET_WILD, string(), partial + "*", rclmatches,
-                          maxdbtermmatch)) {
-      LOGDEB1("KeyWordsCompleterModel: termMatch failed: [" << partial + "*"
-                                                       << "]\n");
-    } else {
-      LOGDEB1("KeyWordsCompleterModel: termMatch cnt: " << rclmatches.entries.size()
-                                                   << endl);
-    }
-    for (const auto &entry : rclmatches.entries) {
-      LOGDEB1("KeyWordsCompleterModel: match " << entry.term << endl);
-      string data = entry.term;
-      currentlist.push_back(QString::fromStdString(data));
+  auto partial = qpartial.trimmed();
+  if (!partial.isEmpty()) {
+    auto matches = TermDict::instance()->complete(partial, maxdbtermmatch);
+    LOGDEB1("KeyWordsCompleterModel: dict matches for [" << partial.toStdString()
+            << "]: " << matches.size() << "\n");
+    for (const auto &m : matches) {
+      if (m.first.compare(partial, Qt::CaseInsensitive) != 0) {
+        currentlist.push_back(m.first);
+      }
     }
   }
-   */
   endResetModel();
 }
 
@@ -188,16 +188,50 @@ void SearchWidget::searchTextEdited(const QString &text) {
 
   m_savedEditText = text.left(cs);
   if (cs >= 0) {
-    //        emit partialWord(tp, currentText(), pword);
+    emit partialWord(0, currentText(), pword);
+  } else {
+    emit partialWord(0, currentText(), " ");
+  }
+  auto completer = queryText->completer();
+  if (m_completermodel->rowCount(QModelIndex()) > 0) {
+    completer->complete();
   } else {
-    //        emit partialWord(tp, currentText(), " ");
+    completer->popup()->hide();
+  }
+}
+
+// 设置了 EVERYLAUNCHER_KEYTRACE 时把每次输入框的变化记录成一行 JSON，
+// 可以用 bench/replay 重放
+static void recordKeyTrace(const QString &text) {
+  static QFile *file = nullptr;
+  static QElapsedTimer clock;
+  if (!clock.isValid()) {
+    clock.start();
+    auto path = qgetenv("EVERYLAUNCHER_KEYTRACE");
+    if (!path.isEmpty()) {
+      file = new QFile(QString::fromLocal8Bit(path));
+      if (!file->open(QIODevice::WriteOnly | QIODevice::Append)) {
+        delete file;
+        file = nullptr;
+      }
+    }
+  }
+  if (file == nullptr) {
+    return;
   }
+  QJsonObject obj;
+  obj["t"] = clock.elapsed();
+  obj["text"] = text;
+  file->write(QJsonDocument(obj).toJson(QJsonDocument::Compact) + "\n");
+  file->flush();
 }
 
 void SearchWidget::searchTextChanged(const QString &text) {
   LOGDEB1("SearchWidget::searchTextChanged: text [" << qs2u8s(text) << "]\n");
+  recordKeyTrace(text);
 
   if(text.trimmed().size()>=2){
+    QueryTrace::beginQuery(text);
     emit startSimpleSearch();
   }else{
     emit clearSearch();
@@ -205,7 +239,10 @@ void SearchWidget::searchTextChanged(const QString &text) {
 }
 
 void SearchWidget::startSimpleSearch() {
-  if (queryText->completer()->popup()->isVisible()) {
+  // 在补全列表里上下选择时会改变输入框的文字，这时不查询；
+  // 正在输入时列表没有当前项，照常查询
+  auto popup = queryText->completer()->popup();
+  if (popup->isVisible() && popup->currentIndex().isValid()) {
     return;
   }
   auto str=queryText->text();
@@ -214,36 +251,19 @@ void SearchWidget::startSimpleSearch() {
       return ;
 
   }
-  QString s("");
-  for(auto tmp:str){
-      if((tmp>='a'&&tmp<='z')||(tmp>='A'&&tmp<='Z')){
-        s+=tmp+QString("*");
-      }else{
-          s+=tmp;
-      }
-  }
-  string u8=s.toStdString();
-  trimstring(u8);
-  if (u8.length() == 0)
-    return;
-
-  if (!startSimpleSearch(u8))
-    return;
-
+  // 最后一个词后面是否有空格决定了它是不是前缀，所以不去掉空白
+  startSimpleSearch(str.toStdString());
 }
 
 
 bool SearchWidget::startSimpleSearch(const string &u8) {
   LOGDEB("SearchWidget::startSimpleSearch(" << u8 << ")\n");
-  // TODO
-  string stemlang = "english";
-
-
-  std::string reason;
-  auto sdata = wasaStringToRcl(theconfig, stemlang, u8, reason);
-
-  std::shared_ptr<Rcl::SearchData> rsdata(sdata);
-  emit setDescription(QString::fromStdString(u8));
+  auto text = QString::fromStdString(u8);
+  auto rsdata = QueryCompiler::compile(text);
+  if (!rsdata) {
+    return false;
+  }
+  emit setDescription(text.trimmed());
   emit startSearch(rsdata, true);
   return true;
 }
@@ -267,10 +287,28 @@ void SearchWidget::onWordReplace(const QString &o, const QString &n) {
 }
 
 /*
- *
+ * 取出输入框中最后一个还没输完的词
+ * @return 这个词在文字中的开始位置，以空格或引号结尾（没有未完成的词）时返回 -1
  */
 int SearchWidget::getPartialWord(QString &word) {
-
+  auto txt = currentText();
+  if (txt.isEmpty()) {
+    return -1;
+  }
+  auto last = txt[txt.size() - 1];
+  if (last.isSpace() || last == '"') {
+    return -1;
+  }
+  int cs = -1;
+  for (int i = txt.size() - 1; i >= 0; i--) {
+    if (txt[i].isSpace() || txt[i] == '"') {
+      cs = i;
+      break;
+    }
+  }
+  cs++;
+  word = txt.mid(cs);
+  return cs;
 }
 
 MLineEdit::MLineEdit(QWidget *parent) : QLineEdit(parent) {
@@ -0,0 +1,182 @@
+#include "searchprovider.h"
+#include "querytrace.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+#include <QtConcurrent>
+
+#include <iterator>
+
+Rcl::Doc SearchProvider::makeDoc(const QString &url, const QString &mimetype,
+                                 const QString &title, const QString &abstract, int score)
+{
+    Rcl::Doc doc;
+    doc.url = url.toStdString();
+    doc.mimetype = mimetype.toStdString();
+    doc.pc = score;
+    doc.meta[Rcl::Doc::keyurl] = doc.url;
+    doc.meta[Rcl::Doc::keymt] = doc.mimetype;
+    doc.meta[Rcl::Doc::keyfn] = title.toStdString();
+    doc.meta[Rcl::Doc::keytt] = title.toStdString();
+    doc.meta[Rcl::Doc::keyabs] = abstract.toStdString();
+    return doc;
+}
+
+ProviderHub *ProviderHub::instance()
+{
+    static auto instance = new ProviderHub;
+    return instance;
+}
+
+ProviderHub::ProviderHub()
+{
+    m_clock.start();
+    // 和建索引、查询线程分开，慢的来源不会占住全局线程池
+    m_pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount() / 2));
+}
+
+void ProviderHub::add(std::shared_ptr<SearchProvider> provider)
+{
+    QMutexLocker locker(&m_mutex);
+    m_providers.push_back(std::move(provider));
+}
+
+quint64 ProviderHub::start(const QString &text, int budgetMs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_round = launch(text, budgetMs);
+    return m_round->id;
+}
+
+quint64 ProviderHub::startDetached(const QString &text, int budgetMs)
+{
+    QMutexLocker locker(&m_mutex);
+    auto round = launch(text, budgetMs);
+    m_detached.insert(round->id, round);
+    return round->id;
+}
+
+// 调用时持有 m_mutex
+std::shared_ptr<ProviderHub::Round> ProviderHub::launch(const QString &text, int budgetMs)
+{
+    auto round = std::make_shared<Round>();
+    round->id = m_nextRound++;
+    round->deadlineMs = m_clock.elapsed() + budgetMs;
+    round->pending = int(m_providers.size());
+    auto query = QueryTrace::currentQuery();
+    for (const auto &provider : m_providers) {
+        QtConcurrent::run(&m_pool, [this, round, provider, text, budgetMs, query]() {
+            auto startUs = QueryTrace::nowUs();
+            QElapsedTimer timer;
+            timer.start();
+            auto docs = provider->query(text, budgetMs);
+            auto elapsed = timer.elapsed();
+            QVariantMap args;
+            args["results"] = int(docs.size());
+            QueryTrace::record("provider " + provider->name(), startUs,
+                               QueryTrace::nowUs() - startUs, args, query);
+            finished(round, provider->name(), std::move(docs), elapsed);
+        });
+    }
+    return round;
+}
+
+void ProviderHub::finished(const std::shared_ptr<Round> &round, const QString &provider,
+                           std::vector<Rcl::Doc> docs, qint64 elapsedMs)
+{
+    bool late, notify;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto &stat = m_stats[provider];
+        stat.calls++;
+        stat.lastMs = elapsedMs;
+        stat.maxMs = qMax(stat.maxMs, elapsedMs);
+        stat.avgMs = stat.calls == 1 ? elapsedMs : 0.8 * stat.avgMs + 0.2 * elapsedMs;
+        late = round->collected;
+        if (late) {
+            stat.late++;
+        }
+        auto &out = late ? round->late : round->onTime;
+        std::move(docs.begin(), docs.end(), std::back_inserter(out));
+        round->pending--;
+        m_done.wakeAll();
+        // 已经开始新一轮的话没人要这些结果了
+        notify = late && round == m_round;
+    }
+    if (notify) {
+        qDebug() << "ProviderHub:" << provider << "late by"
+                 << m_clock.elapsed() - round->deadlineMs << "ms";
+        emit lateResultsReady(round->id);
+    }
+}
+
+std::vector<Rcl::Doc> ProviderHub::collect()
+{
+    QMutexLocker locker(&m_mutex);
+    return collectLocked(m_round);
+}
+
+std::vector<Rcl::Doc> ProviderHub::collect(quint64 round)
+{
+    QMutexLocker locker(&m_mutex);
+    return collectLocked(m_detached.value(round));
+}
+
+std::vector<Rcl::Doc> ProviderHub::collectLocked(const std::shared_ptr<Round> &round)
+{
+    if (!round || round->collected) {
+        return {};
+    }
+    while (round->pending > 0) {
+        auto remaining = round->deadlineMs - m_clock.elapsed();
+        if (remaining <= 0 || !m_done.wait(&m_mutex, remaining)) {
+            break;
+        }
+    }
+    round->collected = true;
+    return std::move(round->onTime);
+}
+
+std::vector<Rcl::Doc> ProviderHub::takeLate(quint64 round)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_round || m_round->id != round) {
+        return {};
+    }
+    return std::move(m_round->late);
+}
+
+std::vector<Rcl::Doc> ProviderHub::finish(quint64 round, int waitMs)
+{
+    QMutexLocker locker(&m_mutex);
+    auto r = m_detached.take(round);
+    if (!r) {
+        return {};
+    }
+    QElapsedTimer timer;
+    timer.start();
+    while (r->pending > 0) {
+        auto remaining = waitMs - timer.elapsed();
+        if (remaining <= 0 || !m_done.wait(&m_mutex, remaining)) {
+            break;
+        }
+    }
+    r->collected = true;
+    return std::move(r->late);
+}
+
+QVariantMap ProviderHub::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    QVariantMap map;
+    for (auto it = m_stats.constBegin(); it != m_stats.constEnd(); ++it) {
+        QVariantMap s;
+        s["calls"] = it->calls;
+        s["late"] = it->late;
+        s["lastMs"] = it->lastMs;
+        s["avgMs"] = it->avgMs;
+        s["maxMs"] = it->maxMs;
+        map[it.key()] = s;
+    }
+    return map;
+}
@@ -0,0 +1,104 @@
+#ifndef SEARCHPROVIDER_H
+#define SEARCHPROVIDER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QVariantMap>
+#include <QWaitCondition>
+
+#include <memory>
+#include <vector>
+
+#include <rcldoc.h>
+
+/*
+ * recoll 以外的结果来源。query() 在线程池里调用，返回的文档和 recoll 的结果
+ * 一样由 RecollModel 显示：url、mimetype、pc（0~100 的分数）以及 meta 里
+ * 的 url、filename、mtype、abstract 等字段。
+ */
+class SearchProvider
+{
+public:
+    virtual ~SearchProvider() = default;
+
+    virtual QString name() const = 0;
+    // budgetMs 是建议的耗时上限，超过了结果会晚一些显示
+    virtual std::vector<Rcl::Doc> query(const QString &text, int budgetMs) = 0;
+
+    // 按 RecollModel 读取的字段填好一个文档
+    static Rcl::Doc makeDoc(const QString &url, const QString &mimetype,
+                            const QString &title, const QString &abstract, int score);
+};
+
+/*
+ * 每次按键时并行调用所有 SearchProvider。
+ * collect() 等到截止时间（start 之后 budgetMs）为止，返回按时完成的结果；
+ * 之后完成的结果通过 lateResultsReady 通知，用 takeLate 取走。
+ * 每个 SearchProvider 的耗时记在 stats() 和 QueryTrace 里。
+ *
+ * startDetached 开始的轮次不影响当前一轮，给没有结果列表的调用方
+ * （命令行、D-Bus 的 Search）用，结果由调用方自己 collect 和 finish。
+ */
+class ProviderHub : public QObject
+{
+    Q_OBJECT
+public:
+    static ProviderHub *instance();
+
+    void add(std::shared_ptr<SearchProvider> provider);
+    // 开始新一轮，返回这一轮的编号，上一轮还没完成的结果会被丢掉
+    quint64 start(const QString &text, int budgetMs);
+    // 每一轮只有第一次调用返回结果
+    std::vector<Rcl::Doc> collect();
+    std::vector<Rcl::Doc> takeLate(quint64 round);
+
+    quint64 startDetached(const QString &text, int budgetMs);
+    std::vector<Rcl::Doc> collect(quint64 round);
+    // 最多再等 waitMs 返回迟到的结果，之后这一轮就被忘掉
+    std::vector<Rcl::Doc> finish(quint64 round, int waitMs);
+
+    QVariantMap stats() const;
+
+signals:
+    void lateResultsReady(quint64 round);
+
+private:
+    struct Round {
+        quint64 id{0};
+        qint64 deadlineMs{0};
+        int pending{0};
+        bool collected{false};
+        std::vector<Rcl::Doc> onTime;
+        std::vector<Rcl::Doc> late;
+    };
+    struct Stat {
+        quint64 calls{0};
+        quint64 late{0};
+        qint64 lastMs{0};
+        double avgMs{0};
+        qint64 maxMs{0};
+    };
+
+    ProviderHub();
+    std::shared_ptr<Round> launch(const QString &text, int budgetMs);
+    std::vector<Rcl::Doc> collectLocked(const std::shared_ptr<Round> &round);
+    void finished(const std::shared_ptr<Round> &round, const QString &provider,
+                  std::vector<Rcl::Doc> docs, qint64 elapsedMs);
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_done;
+    QThreadPool m_pool;
+    QElapsedTimer m_clock;
+    std::vector<std::shared_ptr<SearchProvider>> m_providers;
+    std::shared_ptr<Round> m_round;
+    QHash<quint64, std::shared_ptr<Round>> m_detached;
+    quint64 m_nextRound{1};
+    QHash<QString, Stat> m_stats;
+};
+
+#endif // SEARCHPROVIDER_H
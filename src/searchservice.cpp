@@ -0,0 +1,87 @@
+#include "searchservice.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QTimer>
+#include <QtConcurrent>
+
+#include <rcldb.h>
+
+#include "config.h"
+#include "searchengine.h"
+
+static const int defaultLimit = 20;
+static const int maxLimit = 1000;
+
+SearchService::SearchService(QObject *parent) : QObject(parent)
+{
+    // 数据库对象不能同时在两个线程里用
+    m_pool.setMaxThreadCount(1);
+}
+
+SearchService::~SearchService()
+{
+    m_pool.waitForDone();
+}
+
+void SearchService::invalidate()
+{
+    QMutexLocker locker(&m_mutex);
+    m_db.reset();
+}
+
+uint SearchService::search(const QString &text, int limit)
+{
+    if (limit <= 0) {
+        limit = defaultLimit;
+    }
+    limit = qMin(limit, maxLimit);
+    uint id;
+    std::shared_ptr<Rcl::Db> db;
+    {
+        QMutexLocker locker(&m_mutex);
+        id = m_nextId++;
+        // 在界面线程里创建，构造时复制 theconfig
+        if (!m_db) {
+            m_db = std::make_shared<Rcl::Db>(theconfig);
+        }
+        db = m_db;
+    }
+    QtConcurrent::run(&m_pool, [this, db, id, text, limit]() {
+        Rcl::Db::OpenError error;
+        if (!db->isopen() && !db->open(Rcl::Db::DbRO, &error)) {
+            emit failed(id, "Could not open database");
+            return;
+        }
+        QElapsedTimer timer;
+        timer.start();
+        QString reason;
+        bool ok = SearchEngine::search(db, text, limit,
+                                       [this, id](const SearchEngine::Batch &batch) {
+            QVariantList results;
+            for (const auto &doc : batch.docs) {
+                results << SearchEngine::toVariant(doc);
+            }
+            emit batchReady(id, batch.stage, results, batch.final);
+        }, &reason);
+        if (!ok) {
+            emit failed(id, reason);
+            return;
+        }
+        qDebug() << "SearchService:" << id << text << "in" << timer.elapsed() << "ms";
+    });
+    return id;
+}
+
+uint SearchService::reject(const QString &error)
+{
+    uint id;
+    {
+        QMutexLocker locker(&m_mutex);
+        id = m_nextId++;
+    }
+    // 先让调用方收到编号
+    QTimer::singleShot(0, this, [this, id, error]() { emit failed(id, error); });
+    return id;
+}
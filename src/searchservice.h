@@ -0,0 +1,49 @@
+#ifndef SEARCHSERVICE_H
+#define SEARCHSERVICE_H
+
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QVariantList>
+
+#include <memory>
+
+namespace Rcl {
+class Db;
+}
+
+/*
+ * D-Bus 的 Search。在单独的线程里用 SearchEngine 执行，结果分批用 batchReady 发出，
+ * 其它来源（程序、最近文件、路径索引）和界面共用，已经在内存里了。
+ * 用自己的只读 Rcl::Db，不和界面的查询线程同时用一个数据库对象；
+ * 索引内容变了以后，下一次查询前重新打开。同一时间只执行一个查询，后来的排队。
+ */
+class SearchService : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SearchService(QObject *parent = nullptr);
+    ~SearchService() override;
+
+    // 返回查询编号，结果和这个编号一起发出。limit 不大于 0 时用默认值
+    uint search(const QString &text, int limit);
+    // 不执行查询，返回的编号随后和 error 一起用 failed 发出
+    uint reject(const QString &error);
+
+public slots:
+    void invalidate();
+
+signals:
+    // stage 和 final 的意义见 SearchEngine::Batch，每个结果的字段见 SearchEngine::toVariant
+    void batchReady(uint id, QString stage, QVariantList results, bool final);
+    void failed(uint id, QString error);
+
+private:
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    std::shared_ptr<Rcl::Db> m_db;
+    uint m_nextId{1};
+};
+
+#endif // SEARCHSERVICE_H
@@ -0,0 +1,89 @@
+#include "startuptrace.h"
+
+#include <QEvent>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QWidget>
+
+#include <cstdlib>
+
+QElapsedTimer StartupTrace::s_clock;
+QMutex StartupTrace::s_mutex;
+QVector<StartupTrace::Mark> StartupTrace::s_marks;
+
+void StartupTrace::begin()
+{
+    s_clock.start();
+    mark("start");
+}
+
+void StartupTrace::mark(const QString &phase, bool background)
+{
+    QMutexLocker locker(&s_mutex);
+    if (!s_clock.isValid()) {
+        return;
+    }
+    s_marks.append({phase, s_clock.elapsed(), background});
+}
+
+QVector<StartupTrace::Mark> StartupTrace::marks()
+{
+    QMutexLocker locker(&s_mutex);
+    return s_marks;
+}
+
+QString StartupTrace::report()
+{
+    auto all = marks();
+    QStringList lines;
+    lines << QString("%1 %2 %3").arg("phase", -24).arg("delta(ms)", 10).arg("total(ms)", 10);
+    // 前台和后台线程的阶段分别计算间隔
+    qint64 prevFg = 0, prevBg = -1;
+    for (const auto &m : all) {
+        qint64 &prev = m.background ? prevBg : prevFg;
+        if (prev < 0) {
+            prev = prevFg;
+        }
+        auto name = m.background ? "[bg] " + m.phase : m.phase;
+        lines << QString("%1 %2 %3").arg(name, -24).arg(m.ms - prev, 10).arg(m.ms, 10);
+        prev = m.ms;
+    }
+    return lines.join("\n");
+}
+
+bool StartupTrace::enabled()
+{
+    auto env = getenv("EVERYLAUNCHER_STARTUP_TRACE");
+    return env != nullptr && *env != '0';
+}
+
+namespace {
+class FirstPaintFilter : public QObject
+{
+public:
+    FirstPaintFilter(QWidget *widget, std::function<void()> callback)
+        : QObject(widget), m_callback(std::move(callback)) {
+    }
+
+    bool eventFilter(QObject *watched, QEvent *event) override {
+        if (event->type() == QEvent::Paint && m_callback) {
+            auto callback = std::move(m_callback);
+            m_callback = nullptr;
+            // 先让控件处理这个事件（paintEvent），绘制完成后再回调
+            watched->event(event);
+            callback();
+            deleteLater();
+            return true;
+        }
+        return QObject::eventFilter(watched, event);
+    }
+
+private:
+    std::function<void()> m_callback;
+};
+}
+
+void StartupTrace::onFirstPaint(QWidget *widget, std::function<void()> callback)
+{
+    widget->installEventFilter(new FirstPaintFilter(widget, std::move(callback)));
+}
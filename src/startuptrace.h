@@ -0,0 +1,43 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include <functional>
+
+class QWidget;
+
+/*
+ * 记录启动过程中各个阶段的时间点。
+ * 设置环境变量 EVERYLAUNCHER_STARTUP_TRACE=1 时在第一次绘制后打印，
+ * 使用 --startup-bench 启动时打印后直接退出，用于比较启动时间。
+ */
+class StartupTrace
+{
+public:
+    struct Mark {
+        QString phase;
+        qint64 ms;
+        bool background;
+    };
+
+    static void begin();
+    // 可以从任意线程调用
+    static void mark(const QString &phase, bool background = false);
+    static QVector<Mark> marks();
+    // 每个阶段相对于上一个时间点的耗时
+    static QString report();
+    static bool enabled();
+    // widget 下一次收到 Paint 事件时调用一次 callback
+    static void onFirstPaint(QWidget *widget, std::function<void()> callback);
+
+private:
+    static QElapsedTimer s_clock;
+    static QMutex s_mutex;
+    static QVector<Mark> s_marks;
+};
+
+#endif // STARTUPTRACE_H
@@ -1,5 +1,7 @@
 #include "systemtray.h"
+#include "config.h"
 #include "preferencewindow.h"
+#include "residentmode.h"
 #include <QDebug>
 #include <QIcon>
 #include <confgui/confguiindex.h>
@@ -15,6 +17,7 @@ void SystemTray::showWindow() {
     if(this->mainWindow->isActiveWindow()){
         this->mainWindow->hide();
     }else{
+        ResidentMode::instance()->summonStarted(this->mainWindow);
         this->mainWindow->raise();
         this->mainWindow->show();
   this->mainWindow->activateWindow();
@@ -28,10 +31,12 @@ void SystemTray::init_ui() {
   this->trayMenu = new QMenu();
   this->showUp = new QAction(tr("显示主窗口"), this->trayMenu);
   this->preferenceAction = new QAction(tr("选项"), this->trayMenu);
+  this->indexStatusAction = new QAction(tr("索引状态"), this->trayMenu);
   this->exitAction = new QAction(tr("退出"), this->trayMenu);
 
   this->trayMenu->addAction(this->showUp);
   this->trayMenu->addAction(this->preferenceAction);
+  this->trayMenu->addAction(this->indexStatusAction);
   this->trayMenu->addAction(this->exitAction);
 
   this->setContextMenu(this->trayMenu);
@@ -46,5 +51,22 @@ void SystemTray::init_conn() {
     w.exec();
   });
 
+  connect(this->indexStatusAction, &QAction::triggered, [this]() {
+    PreferenceWindow w(nullptr, this->progressMonitor);
+    w.showIndexStatus();
+    w.exec();
+  });
+
   connect(this->exitAction, &QAction::triggered, this, &SystemTray::exitAll);
 }
+
+void SystemTray::setProgressMonitor(IndexProgressMonitor *monitor) {
+  this->progressMonitor = monitor;
+  connect(monitor, &IndexProgressMonitor::progressChanged, this,
+          &SystemTray::updateIndexProgress);
+  updateIndexProgress(monitor->current());
+}
+
+void SystemTray::updateIndexProgress(const IndexProgress &progress) {
+  this->setToolTip(AppName + "\n" + progress.summary());
+}
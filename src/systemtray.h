@@ -7,6 +7,8 @@
 #include <QSystemTrayIcon>
 #include <rclconfig.h>
 
+#include "indexprogress.h"
+
 extern RclConfig *theconfig;
 class SystemTray : public QSystemTrayIcon
 {
@@ -18,8 +20,10 @@ public:
         return instance;
 
     }
+    void setProgressMonitor(IndexProgressMonitor *monitor);
 public slots:
     void showWindow();
+    void updateIndexProgress(const IndexProgress &progress);
 private:
     void init_ui();
     void init_conn();
@@ -31,6 +35,8 @@ private:
     QMenu *trayMenu;
     QAction *showUp;
     QAction *preferenceAction;
+    QAction *indexStatusAction;
+    IndexProgressMonitor *progressMonitor{nullptr};
     QAction *exitAction;
 };
 
@@ -0,0 +1,209 @@
+#include "termdict.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <vector>
+
+#include <log.h>
+#include <rclconfig.h>
+#include <rcldb.h>
+#include <unacpp.h>
+
+static const char termDictMagic[4] = {'E', 'L', 'T', 'D'};
+static const quint32 termDictVersion = 1;
+// 太长的词不会有人去补全
+static const size_t maxTermLen = 64;
+// complete 在界面线程里每次按键调用，一两个字母的前缀可能有几十万个词，
+// 最多看这么多个，超出的部分不参与排序
+static const int maxCompleteScan = 20000;
+
+TermDict *TermDict::instance()
+{
+    static auto instance = new TermDict;
+    return instance;
+}
+
+QString TermDict::defaultPath()
+{
+    auto dir = QDir(QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation));
+    return dir.absoluteFilePath("termdict.bin");
+}
+
+// 带字段前缀的词（:XXX: 或大写开头）和纯数字不用于补全
+static bool wantedTerm(const std::string &term)
+{
+    if (term.empty() || term.size() > maxTermLen) {
+        return false;
+    }
+    auto c = term[0];
+    if (c == ':' || (c >= 'A' && c <= 'Z')) {
+        return false;
+    }
+    return term.find_first_not_of("0123456789") != std::string::npos;
+}
+
+bool TermDict::build(RclConfig *config, const QString &path)
+{
+    QElapsedTimer timer;
+    timer.start();
+    Rcl::Db db(config);
+    if (!db.open(Rcl::Db::DbRO)) {
+        LOGERR("TermDict::build: cannot open db\n");
+        return false;
+    }
+    std::vector<Entry> entries;
+    std::string pool;
+    auto it = db.termWalkOpen();
+    if (it == nullptr) {
+        return false;
+    }
+    std::string term;
+    // allterms 已经按字节序排好
+    while (db.termWalkNext(it, term)) {
+        if (!wantedTerm(term)) {
+            continue;
+        }
+        auto freq = db.termDocCnt(term);
+        if (freq <= 0) {
+            continue;
+        }
+        entries.push_back({quint32(pool.size()), quint32(freq)});
+        pool += term;
+    }
+    db.termWalkClose(it);
+    // 结尾的哨兵，用来算最后一个词的长度
+    entries.push_back({quint32(pool.size()), 0});
+
+    Header header;
+    memcpy(header.magic, termDictMagic, sizeof(header.magic));
+    header.version = termDictVersion;
+    header.count = entries.size() - 1;
+    header.poolSize = pool.size();
+
+    QFile out(path + ".tmp");
+    if (!out.open(QFile::WriteOnly | QFile::Truncate)) {
+        return false;
+    }
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(Entry));
+    out.write(pool.data(), pool.size());
+    if (!out.flush()) {
+        out.remove();
+        return false;
+    }
+    out.close();
+    // 改名是原子的，界面线程已经映射的旧文件不受影响
+    if (::rename(QFile::encodeName(out.fileName()).constData(),
+                 QFile::encodeName(path).constData()) != 0) {
+        out.remove();
+        return false;
+    }
+    LOGDEB("TermDict::build: " << header.count << " terms in " << timer.elapsed()
+           << " ms\n");
+    return true;
+}
+
+bool TermDict::open(const QString &path)
+{
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QFile::ReadOnly) || m_file.size() < qint64(sizeof(Header))) {
+        return false;
+    }
+    auto base = m_file.map(0, m_file.size());
+    if (base == nullptr) {
+        m_file.close();
+        return false;
+    }
+    auto header = reinterpret_cast<const Header *>(base);
+    qint64 need = sizeof(Header) + qint64(header->count + 1) * sizeof(Entry) + header->poolSize;
+    if (memcmp(header->magic, termDictMagic, sizeof(header->magic)) != 0 ||
+        header->version != termDictVersion || m_file.size() < need) {
+        qWarning() << "TermDict: bad dictionary" << path;
+        m_file.unmap(base);
+        m_file.close();
+        return false;
+    }
+    m_base = base;
+    m_count = header->count;
+    m_entries = reinterpret_cast<const Entry *>(base + sizeof(Header));
+    m_pool = reinterpret_cast<const char *>(m_entries + m_count + 1);
+    return true;
+}
+
+void TermDict::close()
+{
+    if (m_base != nullptr) {
+        m_file.unmap(m_base);
+        m_base = nullptr;
+    }
+    m_file.close();
+    m_entries = nullptr;
+    m_pool = nullptr;
+    m_count = 0;
+}
+
+QByteArray TermDict::termAt(int i) const
+{
+    auto off = m_entries[i].offset;
+    return QByteArray::fromRawData(m_pool + off, m_entries[i + 1].offset - off);
+}
+
+int TermDict::lowerBound(const QByteArray &key) const
+{
+    int lo = 0, hi = m_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (termAt(mid) < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+QVector<TermDict::Completion> TermDict::complete(const QString &prefix, int k) const
+{
+    QVector<Completion> out;
+    if (!isOpen() || prefix.isEmpty() || k <= 0) {
+        return out;
+    }
+    // 索引里的词都去掉了重音并转成小写
+    std::string folded;
+    if (!unacmaybefold(prefix.toStdString(), folded, "UTF-8", UNACOP_UNACFOLD)) {
+        folded = prefix.toLower().toStdString();
+    }
+    auto key = QByteArray::fromStdString(folded);
+
+    typedef std::pair<quint32, int> Item;
+    // 小顶堆，保留文档数最大的 k 个
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> heap;
+    auto first = lowerBound(key);
+    auto last = std::min(m_count, first + maxCompleteScan);
+    for (int i = first; i < last; i++) {
+        auto term = termAt(i);
+        if (!term.startsWith(key)) {
+            break;
+        }
+        Item item(m_entries[i].freq, i);
+        if (int(heap.size()) < k) {
+            heap.push(item);
+        } else if (item.first > heap.top().first) {
+            heap.pop();
+            heap.push(item);
+        }
+    }
+    while (!heap.empty()) {
+        auto item = heap.top();
+        heap.pop();
+        out.prepend(Completion(QString::fromUtf8(termAt(item.second)), item.first));
+    }
+    return out;
+}
@@ -0,0 +1,62 @@
+#ifndef TERMDICT_H
+#define TERMDICT_H
+
+#include <QFile>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+class RclConfig;
+
+/*
+ * 补全用的词典，每次索引后从 Xapian 导出。
+ * 文件按词排序，每个词带有包含它的文档数，使用时 mmap 进来：
+ * 前缀补全只是一次二分查找加上按文档数取前 k 个，不用每次按键都去 termMatch。
+ */
+class TermDict
+{
+public:
+    typedef QPair<QString, quint32> Completion;
+
+    static TermDict *instance();
+    static QString defaultPath();
+    // 从数据库导出，先写临时文件再改名，在索引线程里调用
+    static bool build(RclConfig *config, const QString &path);
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return m_base != nullptr; }
+    int size() const { return m_count; }
+
+    // 以 prefix 开头、文档数最多的 k 个词。前缀很短、匹配的词很多时
+    // 只在按字母顺序的前一部分里找
+    QVector<Completion> complete(const QString &prefix, int k) const;
+    // 按顺序访问所有词，0 <= i < size()
+    QByteArray termAt(int i) const;
+    quint32 freqAt(int i) const { return m_entries[i].freq; }
+
+private:
+    struct Header {
+        char magic[4];
+        quint32 version;
+        quint32 count;
+        quint32 poolSize;
+    };
+    struct Entry {
+        quint32 offset;
+        quint32 freq;
+    };
+
+    TermDict() = default;
+    // 第一个不小于 key 的位置
+    int lowerBound(const QByteArray &key) const;
+
+private:
+    QFile m_file;
+    uchar *m_base{nullptr};
+    const Entry *m_entries{nullptr};
+    const char *m_pool{nullptr};
+    int m_count{0};
+};
+
+#endif // TERMDICT_H
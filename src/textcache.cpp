@@ -0,0 +1,237 @@
+#include "textcache.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+#include <utime.h>
+#include <zstd.h>
+
+#include <pathut.h>
+#include <rcldoc.h>
+
+// 缓存总大小的上限，淘汰到上限的 90% 为止
+static const qint64 maxCacheBytes = 256 * 1024 * 1024;
+// 太大的文件算哈希本身就很慢，不缓存
+static const qint64 maxSourceBytes = 512 * 1024 * 1024;
+// 太短的文本直接转换也很快
+static const int minTextBytes = 256;
+static const int zstdLevel = 3;
+
+TextCache *TextCache::instance()
+{
+    static auto instance = new TextCache;
+    return instance;
+}
+
+void TextCache::setLocation(const QString &dbDir)
+{
+    QMutexLocker locker(&m_mutex);
+    auto dir = QFileInfo(dbDir).dir().absoluteFilePath("textcache");
+    if (dir == m_dir) {
+        return;
+    }
+    m_dir = dir;
+    m_totalBytes = -1;
+    QDir().mkpath(m_dir + "/keys");
+    QDir().mkpath(m_dir + "/blobs");
+}
+
+QString TextCache::keyFor(const Rcl::Doc &idoc, bool html) const
+{
+    if (m_dir.isEmpty() || idoc.url.compare(0, 7, "file://") != 0) {
+        return QString();
+    }
+    // 纯文本读起来比解压还快
+    if (idoc.ipath.empty() && idoc.mimetype.compare(0, 5, "text/") == 0) {
+        return QString();
+    }
+    // 用文件现在的状态，索引里的 fmtime 可能已经过期
+    QFileInfo info(QString::fromStdString(fileurltolocalpath(idoc.url)));
+    if (!info.isFile() || info.size() > maxSourceBytes) {
+        return QString();
+    }
+    auto key = QString("%1\n%2\n%3\n%4\n%5")
+            .arg(info.absoluteFilePath())
+            .arg(QString::fromStdString(idoc.ipath))
+            .arg(info.lastModified().toMSecsSinceEpoch())
+            .arg(info.size())
+            .arg(html);
+    auto digest = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1);
+    return m_dir + "/keys/" + digest.toHex();
+}
+
+QByteArray TextCache::contentHash(const Rcl::Doc &idoc, bool html) const
+{
+    QFile file(QString::fromStdString(fileurltolocalpath(idoc.url)));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!hash.addData(&file)) {
+        return QByteArray();
+    }
+    // 同一个容器里的不同子文档、纯文本和 html 分开保存
+    hash.addData(idoc.ipath.c_str(), int(idoc.ipath.size()) + 1);
+    hash.addData(html ? "h" : "t", 1);
+    return hash.result().toHex();
+}
+
+QString TextCache::blobPath(const QByteArray &hash) const
+{
+    return m_dir + "/blobs/" + QString::fromLatin1(hash) + ".zst";
+}
+
+bool TextCache::get(const Rcl::Doc &idoc, bool html, Rcl::Doc &out)
+{
+    QString keyPath, path;
+    {
+        QMutexLocker locker(&m_mutex);
+        keyPath = keyFor(idoc, html);
+        if (keyPath.isEmpty()) {
+            return false;
+        }
+        QFile keyFile(keyPath);
+        if (!keyFile.open(QIODevice::ReadOnly)) {
+            m_misses++;
+            return false;
+        }
+        path = blobPath(keyFile.readAll().trimmed());
+    }
+
+    QFile blob(path);
+    if (!blob.open(QIODevice::ReadOnly)) {
+        // 数据已经被淘汰
+        QFile::remove(keyPath);
+        QMutexLocker locker(&m_mutex);
+        m_misses++;
+        return false;
+    }
+    auto packed = blob.readAll();
+    blob.close();
+    auto size = ZSTD_getFrameContentSize(packed.constData(), size_t(packed.size()));
+    if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN) {
+        qDebug() << "TextCache: bad entry" << path;
+        QFile::remove(path);
+        QFile::remove(keyPath);
+        return false;
+    }
+    std::string data(size, '\0');
+    auto got = ZSTD_decompress(&data[0], data.size(), packed.constData(), size_t(packed.size()));
+    if (ZSTD_isError(got) || got != size) {
+        qDebug() << "TextCache: decompress failed" << path;
+        return false;
+    }
+    // 第一行是 mimetype
+    auto nl = data.find('\n');
+    if (nl == std::string::npos) {
+        return false;
+    }
+    out = idoc;
+    out.mimetype = data.substr(0, nl);
+    out.text = data.substr(nl + 1);
+    // 记录最近使用时间
+    utime(QFile::encodeName(path).constData(), nullptr);
+    utime(QFile::encodeName(keyPath).constData(), nullptr);
+
+    QMutexLocker locker(&m_mutex);
+    m_hits++;
+    return true;
+}
+
+void TextCache::put(const Rcl::Doc &idoc, bool html, const Rcl::Doc &fdoc)
+{
+    if (fdoc.text.size() < size_t(minTextBytes)) {
+        return;
+    }
+    QString keyPath;
+    {
+        QMutexLocker locker(&m_mutex);
+        keyPath = keyFor(idoc, html);
+    }
+    if (keyPath.isEmpty()) {
+        return;
+    }
+    auto hash = contentHash(idoc, html);
+    if (hash.isEmpty()) {
+        return;
+    }
+    auto path = blobPath(hash);
+
+    qint64 added = 0;
+    if (!QFileInfo::exists(path)) {
+        auto data = fdoc.mimetype + "\n" + fdoc.text;
+        QByteArray packed(int(ZSTD_compressBound(data.size())), Qt::Uninitialized);
+        auto len = ZSTD_compress(packed.data(), size_t(packed.size()),
+                                 data.data(), data.size(), zstdLevel);
+        if (ZSTD_isError(len)) {
+            qDebug() << "TextCache: compress failed" << ZSTD_getErrorName(len);
+            return;
+        }
+        QSaveFile blob(path);
+        if (!blob.open(QIODevice::WriteOnly) ||
+            blob.write(packed.constData(), qint64(len)) != qint64(len) || !blob.commit()) {
+            return;
+        }
+        added = qint64(len);
+    }
+    QSaveFile keyFile(keyPath);
+    if (keyFile.open(QIODevice::WriteOnly)) {
+        keyFile.write(hash);
+        keyFile.commit();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_totalBytes < 0) {
+        m_totalBytes = 0;
+        for (const auto &info : QDir(m_dir + "/blobs").entryInfoList(QDir::Files)) {
+            m_totalBytes += info.size();
+        }
+    } else {
+        m_totalBytes += added;
+    }
+    if (m_totalBytes > maxCacheBytes) {
+        evictLocked();
+    }
+}
+
+void TextCache::evictLocked()
+{
+    // 最久没用过的在前
+    auto blobs = QDir(m_dir + "/blobs").entryInfoList(QDir::Files,
+                                                      QDir::Time | QDir::Reversed);
+    int i = 0;
+    for (; i < blobs.size() && m_totalBytes > maxCacheBytes * 9 / 10; i++) {
+        if (QFile::remove(blobs[i].absoluteFilePath())) {
+            m_totalBytes -= blobs[i].size();
+            m_evicted++;
+        }
+    }
+    if (i >= blobs.size()) {
+        return;
+    }
+    // 比留下的最旧数据还旧的键一起删掉，最多让下次预览重新算一次哈希
+    auto oldest = blobs[i].lastModified();
+    for (const auto &info : QDir(m_dir + "/keys").entryInfoList(QDir::Files)) {
+        if (info.lastModified() < oldest) {
+            QFile::remove(info.absoluteFilePath());
+        }
+    }
+}
+
+QVariantMap TextCache::stats()
+{
+    QMutexLocker locker(&m_mutex);
+    QVariantMap map;
+    map["dir"] = m_dir;
+    map["bytes"] = m_totalBytes;
+    map["maxBytes"] = maxCacheBytes;
+    map["hits"] = m_hits;
+    map["misses"] = m_misses;
+    map["evicted"] = m_evicted;
+    return map;
+}
@@ -0,0 +1,50 @@
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include <QMutex>
+#include <QString>
+#include <QVariantMap>
+
+namespace Rcl {
+class Doc;
+}
+
+/*
+ * 预览用的已转换文本缓存，放在 xapiandb 旁边的 textcache 目录。
+ * blobs/ 下按文件内容的哈希保存 zstd 压缩后的文本，内容相同的文件共用一份；
+ * keys/ 下按 路径+修改时间+大小 记录对应的内容哈希，同一个版本的文件只算一次哈希。
+ * 总大小超过上限时按最近使用时间（blob 的 mtime）淘汰。
+ * 可以从任意线程调用。
+ */
+class TextCache
+{
+public:
+    static TextCache *instance();
+
+    void setLocation(const QString &dbDir);
+
+    // 命中时 out 是 idoc 加上缓存的 text 和 mimetype
+    bool get(const Rcl::Doc &idoc, bool html, Rcl::Doc &out);
+    void put(const Rcl::Doc &idoc, bool html, const Rcl::Doc &fdoc);
+
+    QVariantMap stats();
+
+private:
+    TextCache() = default;
+    // 空字符串表示这个文档不缓存
+    QString keyFor(const Rcl::Doc &idoc, bool html) const;
+    QByteArray contentHash(const Rcl::Doc &idoc, bool html) const;
+    QString blobPath(const QByteArray &hash) const;
+    void evictLocked();
+
+private:
+    QMutex m_mutex;
+    QString m_dir;
+    // -1 表示还没有统计过
+    qint64 m_totalBytes{-1};
+    quint64 m_hits{0};
+    quint64 m_misses{0};
+    quint64 m_evicted{0};
+};
+
+#endif // TEXTCACHE_H
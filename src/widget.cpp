@@ -5,7 +5,20 @@
 #include <QThread>
 #include <QVBoxLayout>
 #include <docseqdb.h>
-
+#include <log.h>
+
+#include "docseqranked.h"
+#include "frecency.h"
+#include "fuzzyindex.h"
+#include "pathindex.h"
+#include "indexscheduler.h"
+#include "querycompiler.h"
+#include "querytrace.h"
+#include "searchengine.h"
+#include "searchhistory.h"
+#include "searchprovider.h"
+#include "startuptrace.h"
+#include "termdict.h"
 #include "widget.h"
 #include "ui_widget.h"
 
@@ -17,11 +30,23 @@ void MainWindow::startSearch(std::shared_ptr<Rcl::SearchData> sdata,
                          bool issimple) {
   if (m_queryActive) {
       qDebug()<<"startSearch already active";
+    emit searchDropped(searchLine->currentText());
+    return;
+  }
+  if (!m_backendReady) {
+    m_pendingSearch = std::move(sdata);
     return;
   }
   m_queryActive = true;
+  // 第一阶段的结果显示以后界面会继续处理事件，滚动不能在界面线程里用同一个数据库
+  restable->getModel()->setPagingEnabled(false);
+  emit searchStarted(searchLine->currentText());
+  // 只有 fuzzyRetry 发起的查询是容错查询
+  m_fuzzyStage = m_fuzzyPending;
+  m_fuzzyPending = false;
   restable->setEnabled(false);
   m_source = std::shared_ptr<DocSequence>();
+  m_ranked = std::shared_ptr<DocSeqRanked>();
 
   string reason;
   // If indexing is being performed, we reopen the db at each query.
@@ -31,58 +56,61 @@ void MainWindow::startSearch(std::shared_ptr<Rcl::SearchData> sdata,
     QMessageBox::critical(0, "Recoll", QString(reason.c_str()),
                           QMessageBox::Ok);
     m_queryActive = false;
+    restable->getModel()->setPagingEnabled(true);
     restable->setEnabled(true);
     return;
   }
 
 
-  auto *query = new Rcl::Query(rcldb.get());
-  query->setCollapseDuplicates(true);
-
-  DocSequenceDb *src =
-      new DocSequenceDb(/*rcldb,*/ std::shared_ptr<Rcl::Query>(query),
-                        string(tr("Query results").toUtf8()), std::move(sdata));
-  src->setAbstractParams(true, false);
-  m_source = std::shared_ptr<DocSequence>(src);
-
-  DocSeqSortSpec dsss;
-  dsss.field="mtype";
-  DocSeqFiltSpec dsfs;
-
-  m_source->setSortSpec(dsss);
-  m_source->setFiltSpec(dsfs);
-
-//  emit useFilterProxy();
-  emit docSourceChanged(m_source);
+  // 查询本身在查询线程里执行
+  m_pending = SearchEngine::prepare(rcldb, std::move(sdata), searchLine->currentText(),
+                                    string(tr("Query results").toUtf8()));
+  m_sdata = m_pending.sdata;
+  m_source = m_pending.source;
+  m_ranked = m_pending.ranked;
+  if (m_fuzzyStage) {
+    m_ranked->setLeading(std::move(m_fuzzyLeading));
+  } else {
+    m_fuzzyProvided.clear();
+  }
+  m_fuzzyLeading.clear();
+  // 先只查文件名和标题，容错查询不分阶段
+  if (issimple && !m_fuzzyStage) {
+    m_pendingNames = QueryCompiler::compileNames(searchLine->currentText());
+  }
+  // 其它来源和 recoll 查询同时进行
+  if (!m_fuzzyStage) {
+    m_providerRound =
+        ProviderHub::instance()->start(searchLine->currentText(),
+                                      SearchEngine::providerBudgetMs);
+  }
   initiateQuery();
 }
 
 class QueryThread : public QThread {
-  std::shared_ptr<DocSequence> m_source;
+  SearchEngine::Pass m_pass;
+  bool m_estimateTotal;
 
 public:
-    explicit QueryThread(std::shared_ptr<DocSequence> source) : m_source(std::move(source)) {}
+    QueryThread(SearchEngine::Pass pass, bool estimateTotal = true)
+        : m_pass(std::move(pass)), m_estimateTotal(estimateTotal) {}
   ~QueryThread() override = default;
 
-    void run() override { cnt = m_source->getResCnt(); }
+    void run() override {
+      cnt = SearchEngine::execute(m_pass, m_estimateTotal);
+    }
   int cnt{0};
 };
 
-void MainWindow::initiateQuery() {
-  if (!m_source)
-    return;
-
-  QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-  QueryThread qthr(m_source);
-  qthr.start();
-
+// 等查询线程结束，期间继续处理界面事件，时间长了显示进度对话框
+static void waitForQuery(QWidget *parent, QThread &qthr) {
 //  DCircleProgress circleProgress(this);
 //  circleProgress.setText(tr("正在进行查询，<bt>"
 //                            "如果取消将退出程序。"));
 //  circleProgress.setWindowModality(Qt::WindowModal);
-  QProgressDialog progress(this);
-  progress.setLabelText(tr("正在进行查询<br>"
-                           "取消将退出程序<br>"));
+  QProgressDialog progress(parent);
+  progress.setLabelText(MainWindow::tr("正在进行查询<br>"
+                                       "取消将退出程序<br>"));
   progress.setWindowModality(Qt::WindowModal);
   progress.setRange(0, 0);
 
@@ -101,47 +129,199 @@ void MainWindow::initiateQuery() {
 
     qApp->processEvents();
   }
+}
+
+void MainWindow::publishNameHits() {
+  auto names = SearchEngine::prepare(rcldb, std::move(m_pendingNames),
+                                     searchLine->currentText(),
+                                     string(tr("Name matches").toUtf8()),
+                                     SearchEngine::nameHitsTopK);
+  {
+    QueryTrace::Span span("name pass");
+    QueryThread qthr(names, false);
+    qthr.start();
+    waitForQuery(this, qthr);
+    span.setArg("docs", qthr.cnt);
+  }
+  auto docs = SearchEngine::docs(*names.ranked, -1);
+  if (docs.empty()) {
+    return;
+  }
+  // 全文查询的结果接在这些后面
+  m_ranked->setLeading(std::move(docs));
+  emit docSourceChanged(names.ranked);
+  emit resultsReady();
+  restable->setEnabled(true);
+}
 
-  int cnt = qthr.cnt;
+void MainWindow::initiateQuery() {
+  if (!m_ranked)
+    return;
+
+  QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+  if (m_pendingNames) {
+    publishNameHits();
+  }
+  QueryThread qthr(std::move(m_pending));
+  m_pending = SearchEngine::Pass();
+  qthr.start();
+  waitForQuery(this, qthr);
+
+  // 截止时间之前完成的其它来源和第一页一起排序。
+  // 容错查询没有新的一轮，用第一次查询时收到的
+  std::vector<Rcl::Doc> provided;
+  if (m_fuzzyStage) {
+    provided.swap(m_fuzzyProvided);
+  } else {
+    provided = ProviderHub::instance()->collect();
+  }
+  bool fuzzy = !m_fuzzyStage && SearchEngine::needsFuzzy(m_ranked->sourceCount(), provided);
+  m_ranked->merge(std::move(provided));
 
   QApplication::restoreOverrideCursor();
   m_queryActive = false;
+  restable->getModel()->setPagingEnabled(true);
   restable->setEnabled(true);
+  if (fuzzy && fuzzyRetry()) {
+    return;
+  }
+  emit docSourceChanged(m_ranked);
   emit(resultsReady());
+  auto query = QueryTrace::currentQuery();
+  auto shown = QueryTrace::nowUs();
+  StartupTrace::onFirstPaint(restable->resultView(), [query, shown]() {
+    QueryTrace::record("first paint", shown, QueryTrace::nowUs() - shown,
+                       QVariantMap(), query);
+    if (QueryTrace::currentQuery() == query) {
+      QueryTrace::endQuery();
+    }
+  });
+}
+
+void MainWindow::onLateResults(quint64 round) {
+  if (round != m_providerRound || !m_ranked) {
+    return;
+  }
+  auto docs = ProviderHub::instance()->takeLate(round);
+  if (docs.empty()) {
+    return;
+  }
+  m_ranked->append(std::move(docs));
+  emit docSourceChanged(m_ranked);
+  emit resultsReady();
+}
+
+bool MainWindow::fuzzyRetry() {
+  auto sdata = SearchEngine::fuzzyQuery(searchLine->currentText());
+  if (sdata == nullptr) {
+    return false;
+  }
+  m_fuzzyPending = true;
+  m_fuzzyLeading = m_ranked->leadingDocs();
+  m_fuzzyProvided = m_ranked->mergedDocs();
+  startSearch(std::move(sdata), true);
+  return true;
 }
 
 void MainWindow::IndexSomeFiles(QStringList paths) {
-  auto t = QSet<QString>::fromList(paths);
-  QMutexLocker locker(&mtxTobeIndex);
-  tobeIndex.unite(t);
+  idxQueue->enqueueChanged(paths);
+}
+
+void MainWindow::PurgeSomeFiles(QStringList paths) {
+  idxQueue->enqueueDeleted(paths);
+}
+
+void MainWindow::IndexAll() {
+  idxQueue->requestFullPass();
+}
+
+void MainWindow::startFsWatcher() {
+  if (fsWatcher == nullptr) {
+    fsWatcher = new FsWatcher(theconfig, this);
+    connect(fsWatcher, &FsWatcher::filesChanged, this,
+            &MainWindow::IndexSomeFiles);
+    connect(fsWatcher, &FsWatcher::filesDeleted, this,
+            &MainWindow::PurgeSomeFiles);
+    connect(fsWatcher, &FsWatcher::rescanNeeded, this,
+            &MainWindow::IndexAll);
+    connect(fsWatcher, &FsWatcher::filesChanged, m_pathIndex.get(),
+            &PathIndex::filesChanged);
+    connect(fsWatcher, &FsWatcher::filesDeleted, m_pathIndex.get(),
+            &PathIndex::filesDeleted);
+    connect(fsWatcher, &FsWatcher::rescanNeeded, m_pathIndex.get(),
+            &PathIndex::rebuild);
+  }
+  fsWatcher->start();
+}
+
+void MainWindow::stopFsWatcher() {
+  if (fsWatcher != nullptr) {
+    fsWatcher->stop();
+  }
+}
+
+void MainWindow::onScheduledPass(bool full) {
+  idxQueue->requestFullPass(full);
+}
+
+void MainWindow::onSchedulerPause() {
+  // 只中断完整索引，实时的小批量继续
+  if (m_indexAvtive && m_currentBatch.full) {
+    worker->requestStop();
+  }
 }
 
 void MainWindow::filterChanged(QString field)
 {
-  DocSeqFiltSpec dsfs;
-  dsfs.orCrit(DocSeqFiltSpec::DSFS_MIMETYPE,field.toStdString());
-  m_source->setFiltSpec(dsfs);
-  emit docSourceChanged(m_source);
-  initiateQuery();
-
+  if (!m_ranked) {
+    return;
+  }
+  // 已经取出的结果直接在内存里过滤，只有这一组还可能有更多结果时
+  // 才准备一个只查这一组的查询，滚动到底部时才按页执行
+  // 和当前结果用同一个数据库，rcldb 可能已经换过了
+  std::shared_ptr<DocSequence> more;
+  auto db = m_ranked->db();
+  if (m_ranked->canFetchMore() && m_sdata && db && field.contains('/')) {
+    auto query = std::make_shared<Rcl::Query>(db.get());
+    query->setCollapseDuplicates(true);
+    auto src = std::make_shared<DocSequenceDb>(
+        query, string(tr("Query results").toUtf8()), m_sdata);
+    src->setAbstractParams(true, false);
+    DocSeqFiltSpec dsfs;
+    dsfs.orCrit(DocSeqFiltSpec::DSFS_MIMETYPE, field.toStdString());
+    src->setFiltSpec(dsfs);
+    more = src;
+  }
+  auto view = m_ranked->filtered(field, std::move(more));
+  LOGDEB("MainWindow::filterChanged: " << field.toStdString() << ", "
+         << view->getResCnt() << " cached docs\n");
+  emit docSourceChanged(view);
+  emit resultsReady();
 }
 
 MainWindow::MainWindow(QWidget *parent) :DMainWindow(parent) {
   this->restable = new ResTable(this);
   this->searchLine = new SearchWidget(this);
-  this->idxProcess = new QProcess(this);
-  this->idxTimer = new QTimer(this);
+  this->countLabel = new QLabel(this);
+  this->idxQueue = new IndexQueue(this);
+  this->idxProgress = new IndexProgressMonitor(this);
+  this->m_providerRound = 0;
+  this->m_pathIndex = std::make_shared<PathIndex>();
+  SearchEngine::registerProviders(m_pathIndex);
+  this->idxWorkerThread = nullptr;
+  this->worker = nullptr;
+  this->fsWatcher = nullptr;
   this->m_indexAvtive = false;
   this->m_queryActive=false;
   this->m_indexed = false;
+  this->m_backendReady = false;
+  this->m_fuzzyPending = false;
+  this->m_fuzzyStage = false;
   this->escKey=new QShortcut(QKeySequence(Qt::Key_Escape),this);
   this->upKey=new QShortcut(QKeySequence(Qt::Key_Up),this);
   this->downkey=new QShortcut(QKeySequence(Qt::Key_Down),this);
   init_ui();
   init_conn();
-  // TODO configure
-  this->idxTimer->setInterval(4000);
-  this->idxTimer->start();
 }
 
 
@@ -155,7 +335,9 @@ void MainWindow::init_ui() {
 
   this->centralWidget()->setLayout(mvLayout);
   mvLayout->addWidget(searchLine);
+  mvLayout->addWidget(countLabel);
   mvLayout->addWidget(restable);
+  countLabel->setVisible(false);
 }
 
 void MainWindow::init_conn() {
@@ -166,6 +348,18 @@ void MainWindow::init_conn() {
   connect(this->searchLine,&SearchWidget::returnPressed,this->restable,&ResTable::returnPressed);
 
   connect(restable,&ResTable::filterChanged,this,&MainWindow::filterChanged);
+  connect(ProviderHub::instance(), &ProviderHub::lateResultsReady, this,
+          &MainWindow::onLateResults);
+  connect(restable, &ResTable::resultCountChanged, [this](int shown, int estimated) {
+    // 估计值只是个大概，显示的行数比它多时以显示的为准
+    countLabel->setText(shown < estimated ? tr("约 %1 个结果").arg(estimated)
+                                          : tr("%1 个结果").arg(shown));
+    countLabel->setVisible(shown > 0);
+  });
+  connect(restable, &ResTable::docOpened, [this](QString docKey) {
+    FrecencyStore::instance()->record(searchLine->currentText(), docKey);
+    SearchHistory::add(searchLine->currentText());
+  });
 
   connect(this, SIGNAL(docSourceChanged(std::shared_ptr<DocSequence>)),
           restable, SLOT(setDocSource(std::shared_ptr<DocSequence>)));
@@ -174,51 +368,109 @@ void MainWindow::init_conn() {
   connect(this,&MainWindow::useFilterProxy,restable,&ResTable::useFilterProxy);
 
 
+  connect(this->idxQueue, &IndexQueue::ready, this, &MainWindow::toggleIndexing);
+  auto scheduler = IndexScheduler::instance();
+  connect(scheduler, &IndexScheduler::passDue, this, &MainWindow::onScheduledPass);
+  connect(scheduler, &IndexScheduler::pauseRequested, this,
+          &MainWindow::onSchedulerPause);
+  connect(scheduler, &IndexScheduler::realtimeToggled, [this](bool enabled) {
+    if (enabled) {
+      startFsWatcher();
+    } else {
+      stopFsWatcher();
+    }
+  });
+
   connect(this->escKey,&QShortcut::activated,this->searchLine,&SearchWidget::clearAll);
   connect(this->upKey,&QShortcut::activated,this->restable,&ResTable::currentMoveUp);
   connect(this->downkey,&QShortcut::activated,this->restable,&ResTable::currentMoveDown);
 
-  connect(this->idxTimer, &QTimer::timeout, this, &MainWindow::toggleIndexing);
-
-  connect(this->idxProcess,QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished)
-          , [this]() {
-      qDebug()<<"fi1";
-            this->m_indexAvtive = false;
-            this->m_indexed = true;
-          });
-  connect(this->idxProcess,&QProcess::errorOccurred,[this](){
-      qDebug()<<"fi2";
-            this->m_indexAvtive = false;
-            this->m_indexed = true;
+}
 
-  });
-  connect(this->idxProcess, &QProcess::started,
-          [this]() { this->m_indexAvtive = true; });
+MainWindow::~MainWindow() {
+  if (idxWorkerThread != nullptr) {
+    worker->requestStop();
+    idxWorkerThread->quit();
+    idxWorkerThread->wait();
+    delete worker;
+  }
+}
 
+IndexWorker *MainWindow::indexWorker() {
+  if (worker == nullptr) {
+    worker = new IndexWorker(theconfig);
+    idxWorkerThread = new QThread(this);
+    worker->moveToThread(idxWorkerThread);
+    connect(idxWorkerThread, &QThread::started, worker,
+            &IndexWorker::applyIdlePriority);
+    connect(worker, &IndexWorker::indexingFinished, this,
+            &MainWindow::onIndexingFinished);
+    connect(worker, &IndexWorker::statsUpdated, idxProgress,
+            &IndexProgressMonitor::setWorkerProgress);
+    connect(worker, &IndexWorker::termDictExported, this,
+            [](QString path) {
+              if (TermDict::instance()->open(path)) {
+                FuzzyIndex::instance()->rebuild();
+              }
+            });
+    // 索引不能和界面、查询抢 CPU
+    idxWorkerThread->start(QThread::IdlePriority);
+  }
+  return worker;
 }
 
-void MainWindow::toggleIndexing() {
-  if (m_indexAvtive) {
-    qDebug() << "already indexing";
-    return;
+void MainWindow::onIndexingFinished(bool ok, bool interrupted, quint64 generation,
+                                     int files) {
+  if (!ok) {
+    qDebug() << "indexing failed";
   }
-  QStringList sl;
-  {
-    QMutexLocker locker(&mtxTobeIndex);
-    sl = QStringList::fromSet(tobeIndex);
-    tobeIndex.clear();
+  m_indexAvtive = false;
+  // 下一次查询时重新打开数据库
+  m_indexed = true;
+  emit indexGenerationChanged(generation);
+  // 索引期间积累下来的文件会在队列认为合适的时候再次触发
+  if (m_currentBatch.full) {
+    IndexScheduler::instance()->passFinished(ok, interrupted);
   }
+  idxQueue->batchDone(m_currentBatch, m_batchTimer.elapsed(), files);
+  m_currentBatch = IndexQueue::Batch();
+}
 
-  if(sl.size()==0){
-      return;
+void MainWindow::setBackendReady() {
+  m_backendReady = true;
+  RecollModel::addStoredFields();
+  // 上一次运行导出的词典
+  if (TermDict::instance()->open(TermDict::defaultPath())) {
+    FuzzyIndex::instance()->rebuild();
   }
-  QStringList args;
-  args << "-c";
-  args<<QString::fromStdString(theconfig->getConfDir());
-  args << "-i";
-  for(auto item:sl){
-      args<<item;
+  // 需要 theconfig 中的 topdirs
+  m_pathIndex->openOrBuild();
+  // 队列里可能已经有等待的文件
+  toggleIndexing();
+  if (m_pendingSearch) {
+    startSearch(std::move(m_pendingSearch), true);
   }
+}
 
-  idxProcess->start("recollindex", args);
+void MainWindow::toggleIndexing() {
+  if (m_indexAvtive || !m_backendReady) {
+    return;
+  }
+  m_currentBatch = idxQueue->takeBatch();
+  if (m_currentBatch.isEmpty()) {
+    return;
+  }
+  auto w = indexWorker();
+  m_indexAvtive = true;
+  m_batchTimer.start();
+  if (m_currentBatch.full) {
+    QMetaObject::invokeMethod(w, "indexAll", Qt::QueuedConnection,
+                              Q_ARG(bool, m_currentBatch.reset));
+  } else if (m_currentBatch.purge) {
+    QMetaObject::invokeMethod(w, "purgeFiles", Qt::QueuedConnection,
+                              Q_ARG(QStringList, m_currentBatch.paths));
+  } else {
+    QMetaObject::invokeMethod(w, "indexFiles", Qt::QueuedConnection,
+                              Q_ARG(QStringList, m_currentBatch.paths));
+  }
 }
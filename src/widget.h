@@ -1,12 +1,18 @@
 #ifndef WIDGET_H
 #define WIDGET_H
 
+#include "docseqranked.h"
+#include "fswatcher.h"
+#include "indexprogress.h"
+#include "indexqueue.h"
+#include "indexworker.h"
+#include "pathindex.h"
 #include "reslistwidget.h"
+#include "searchengine.h"
 #include "searchline.h"
 
-#include <QSet>
+#include <QElapsedTimer>
 #include <QLabel>
-#include <QMutex>
 #include <QProcess>
 #include <QTimer>
 #include <QWidget>
@@ -19,25 +25,39 @@ DWIDGET_USE_NAMESPACE
 namespace Ui {
 class Widget;
 }
-class IndexWorker;
-
 class MainWindow : public DMainWindow
 {
     Q_OBJECT
 
 public:
     explicit MainWindow(QWidget *parent = nullptr);
-    ~MainWindow() = default;
+    ~MainWindow() override;
+
+    IndexWorker *indexWorker();
+    IndexQueue *indexQueue() { return idxQueue; }
+    IndexProgressMonitor *indexProgress() { return idxProgress; }
+    // 配置和数据库在后台线程里初始化完成后调用
+    void setBackendReady();
+    bool backendReady() const { return m_backendReady; }
 
 public slots:
 virtual void startSearch(std::shared_ptr<Rcl::SearchData> sdata, bool issimple);
     virtual void initiateQuery();
     void IndexSomeFiles(QStringList paths);
+    void PurgeSomeFiles(QStringList paths);
+    void IndexAll();
+    void startFsWatcher();
+    void stopFsWatcher();
 signals:
     void resultsReady();
     void docSourceChanged(std::shared_ptr<DocSequence>);
     void searchReset();
     void useFilterProxy();
+    // 索引内容发生了变化，查询需要重新打开数据库
+    void indexGenerationChanged(quint64 generation);
+    // 一次查询开始执行，或者因为上一次还没结束被丢弃
+    void searchStarted(QString text);
+    void searchDropped(QString text);
 public slots:
     void filterChanged(QString field);
 //private slots:
@@ -47,20 +67,53 @@ private:
     void init_conn();
 
     virtual void toggleIndexing();
+    void onIndexingFinished(bool ok, bool interrupted, quint64 generation, int files);
+    void onScheduledPass(bool full);
+    void onSchedulerPause();
+    // 结果太少时把查询词扩展成近似词再查一次，没有可扩展的词时返回 false
+    bool fuzzyRetry();
+    // 两阶段查询的第一阶段：只查名字，结果马上显示，全文查询的结果接在后面
+    void publishNameHits();
+    // 截止时间之后才完成的其它来源，接在结果后面
+    void onLateResults(quint64 round);
 private:
     QThread *idxWorkerThread;
     IndexWorker *worker;
-    QTimer	*idxTimer;
+    FsWatcher *fsWatcher;
+    // 文件名索引，跟着 fsWatcher 的事件更新
+    std::shared_ptr<PathIndex> m_pathIndex;
 
     std::shared_ptr<DocSequence> m_source;
+    // m_source 重排后的结果，交给结果列表显示
+    std::shared_ptr<DocSeqRanked> m_ranked;
+    // 新查询还没有 setQuery，交给查询线程
+    SearchEngine::Pass m_pending;
+    // 当前查询，按分组查看时用来查这一组后面的结果
+    std::shared_ptr<Rcl::SearchData> m_sdata;
+    // 第一阶段的查询，没有时只做全文查询
+    std::shared_ptr<Rcl::SearchData> m_pendingNames;
+    // 当前查询对应的 ProviderHub 轮次
+    quint64 m_providerRound;
     ResTable *restable;
     SearchWidget *searchLine;
-    QSet<QString> tobeIndex;
-    QMutex mtxTobeIndex;
-    QProcess *idxProcess;
+    // 显示估计的结果数
+    QLabel *countLabel;
+    IndexQueue *idxQueue;
+    IndexProgressMonitor *idxProgress;
+    IndexQueue::Batch m_currentBatch;
+    QElapsedTimer m_batchTimer;
     bool m_queryActive;
     bool m_indexAvtive;
     bool m_indexed;
+    bool m_backendReady;
+    bool m_fuzzyPending;
+    // 当前结果来自容错查询
+    bool m_fuzzyStage;
+    // 容错查询沿用第一次查询的名字结果和其它来源的结果
+    std::vector<Rcl::Doc> m_fuzzyLeading;
+    std::vector<Rcl::Doc> m_fuzzyProvided;
+    // 后端还没准备好时输入的查询，准备好后再执行
+    std::shared_ptr<Rcl::SearchData> m_pendingSearch;
     QShortcut *escKey;
     QShortcut *upKey;
     QShortcut *downkey;